@@ -477,6 +477,15 @@ START_NAMESPACE_DISTRHO
  */
 #define DISTRHO_PLUGIN_NUM_OUTPUTS 2
 
+/**
+   Number of parameters the plugin has.@n
+   This is optional, but when set the plugin wrappers know the parameter count at compile time,
+   allowing the compiler to unroll the per-block parameter loops.@n
+   It must match the @a parameterCount given in the Plugin constructor.
+   @see ParameterDescriptor
+ */
+#define DISTRHO_PLUGIN_NUM_PARAMETERS 3
+
 /**
    The plugin URI when exporting in LV2 format.
    @note This macro is required.
@@ -549,6 +558,39 @@ START_NAMESPACE_DISTRHO
  */
 #define DISTRHO_PLUGIN_WANT_TIMEPOS 1
 
+/**
+   Wherever all plugin instances share the same metadata.@n
+   When enabled, the audio port, parameter, program and state information is initialized only once,
+   by the first instance, and reused by every instance created afterwards.
+   This makes instantiation faster, but the init functions must not depend on per-instance data,
+   such as setting parameter ranges based on the current sample rate.
+   @see Plugin::initParameter(uint32_t, Parameter&)
+ */
+#define DISTRHO_PLUGIN_WANT_SHARED_METADATA 1
+
+/**
+   Wherever the plugin sends a stream of values to the %UI, such as audio for an oscilloscope or analyser.@n
+   The DSP side writes from the audio thread without blocking, the %UI side reads during idle.@n
+   Not available in DSSI, where the %UI runs in a separate process.
+   @see Plugin::writeUIStream(const float*, uint32_t, uint32_t)
+   @see UI::readUIStream(float*, uint32_t)
+ */
+#define DISTRHO_PLUGIN_WANT_UI_STREAM 1
+
+/**
+   Number of values the DSP to %UI stream can hold, rounded up to a power of 2.@n
+   Values written while the stream is full are dropped. Default is 16384.
+ */
+#define DISTRHO_PLUGIN_UI_STREAM_SIZE 16384
+
+/**
+   Wherever the plugin can render a small inline display, shown by hosts in their mixer or rack views.@n
+   This works without a %UI, the image is drawn directly from DSP-side data.@n
+   Currently only supported in the Carla format.
+   @see Plugin::renderInlineDisplay(InlineDisplayImage&)
+ */
+#define DISTRHO_PLUGIN_WANT_INLINE_DISPLAY 1
+
 /**
    Wherever the %UI uses NanoVG for drawing instead of the default raw OpenGL calls.@n
    When enabled your %UI instance will subclass @ref NanoWidget instead of @ref Widget.
@@ -310,6 +310,51 @@ struct Parameter {
           ranges(def, min, max) {}
 };
 
+/**
+   Parameter descriptor.@n
+   This is a plain data version of Parameter, meant to be used in constant tables:
+   @code
+   static const ParameterDescriptor kParameters[kParameterCount] = {
+       { kParameterIsAutomable, "Gain", "gain", "dB", 0.0f, -90.0f, 30.0f },
+       { kParameterIsAutomable|kParameterIsBoolean, "Bypass", "bypass", "", 0.0f, 0.0f, 1.0f }
+   };
+   @endcode
+   A table like this is built by the compiler, and can be passed to the Plugin constructor
+   instead of implementing Plugin::initParameter().
+   @see Plugin::Plugin(const ParameterDescriptor*, uint32_t, uint32_t, uint32_t)
+ */
+struct ParameterDescriptor {
+   /**
+      Hints describing this parameter.
+      @see ParameterHints
+    */
+    uint32_t hints;
+
+   /**
+      The name of this parameter.
+      @see Parameter::name
+    */
+    const char* name;
+
+   /**
+      The symbol of this parameter.
+      @see Parameter::symbol
+    */
+    const char* symbol;
+
+   /**
+      The unit of this parameter.
+      @see Parameter::unit
+    */
+    const char* unit;
+
+   /**
+      Default, minimum and maximum values.
+      @see ParameterRanges
+    */
+    float def, min, max;
+};
+
 /**
    MIDI event.
  */
@@ -436,6 +481,33 @@ struct TimePosition {
           bbt() {}
 };
 
+/**
+   Inline display image.@n
+   Pixels are 32-bit native-endian ARGB values with premultiplied alpha, the same as Cairo's ARGB32 format.
+   @see Plugin::renderInlineDisplay(InlineDisplayImage&)
+ */
+struct InlineDisplayImage {
+   /**
+      Pixel data, @a height rows of @a stride bytes each.
+    */
+    uint8_t* data;
+
+   /**
+      Width in pixels.
+    */
+    uint32_t width;
+
+   /**
+      Height in pixels.
+    */
+    uint32_t height;
+
+   /**
+      Number of bytes between the start of 2 consecutive rows.
+    */
+    uint32_t stride;
+};
+
 /** @} */
 
 /* ------------------------------------------------------------------------------------------------------------
@@ -481,6 +553,15 @@ public:
     */
     Plugin(uint32_t parameterCount, uint32_t programCount, uint32_t stateCount);
 
+   /**
+      Plugin class constructor using a constant parameter table.@n
+      The parameters are taken from @a parameters, which must have @a parameterCount entries
+      and stay valid for the lifetime of the plugin.@n
+      initParameter() is not called when using this constructor.@n
+      You must set all parameter values to their defaults, matching ParameterDescriptor::def.
+    */
+    Plugin(const ParameterDescriptor* parameters, uint32_t parameterCount, uint32_t programCount, uint32_t stateCount);
+
    /**
       Destructor.
     */
@@ -509,10 +590,28 @@ public:
    /**
       Get the current host transport time position.@n
       This function should only be called during run().@n
-      You can call this during other times, but the returned position is not guaranteed to be in sync.
+      You can call this during other times, but the returned position is not guaranteed to be in sync.@n
+      Some formats only query the host the first time this is called within a run() call,
+      so plugins that do not need the transport on every block do not pay for it.
       @note TimePosition is not supported in LADSPA and DSSI plugin formats.
     */
     const TimePosition& getTimePosition() const noexcept;
+
+   /**
+      Get the host transport time position at @a frame within the current block.@n
+      The position is extrapolated from the one at the start of the block, assuming constant tempo,
+      so tempo-synced code can get exact bar, beat and tick values without deriving them itself.@n
+      This function should only be called during run().
+    */
+    TimePosition getTimePosition(uint32_t frame) const noexcept;
+
+   /**
+      Fill @a phase with the transport beat phase of each of the next @a frames frames.@n
+      The phase goes from 0.0 to 1.0 once every @a beatsPerCycle beats, for use as tempo-synced LFO or delay ramp.@n
+      The phase stays constant while the transport is stopped, and is 0.0 if the host does not provide BBT information.@n
+      This function should only be called during run().
+    */
+    void getBeatPhase(float* phase, uint32_t frames, double beatsPerCycle = 1.0) const noexcept;
 #endif
 
 #if DISTRHO_PLUGIN_WANT_LATENCY
@@ -529,13 +628,26 @@ public:
       Write a MIDI output event.@n
       This function must only be called during run().@n
       Returns false when the host buffer is full, in which case do not call this again until the next run().
-      @note This function is not implemented yet!@n
-            It's here so that developers can prepare MIDI plugins in advance.@n
-            If you plan to use this, please report to DPF authos so it can be implemented.
+      @note Only the JACK standalone supports MIDI output for now, other formats always return false.
     */
     bool writeMidiEvent(const MidiEvent& midiEvent) noexcept;
 #endif
 
+#if DISTRHO_PLUGIN_WANT_UI_STREAM
+   /**
+      Write audio or meter data to the %UI stream.@n
+      The data goes into a wait-free ring buffer that the %UI reads with UI::readUIStream().@n
+      Only every @a decimation value of @a data is written, keeping the decimation phase between calls,
+      which can be used to limit the amount of data sent to the %UI.@n
+      This function must only be called during run().@n
+      Returns false when the stream buffer is full, in which case the remaining values are dropped.
+      @note This function is only available if DISTRHO_PLUGIN_WANT_UI_STREAM is enabled.
+      @note The stream is not supported in the LADSPA and DSSI plugin formats or in builds without a %UI,
+            where no buffer is allocated and this function always returns false.
+    */
+    bool writeUIStream(const float* data, uint32_t count, uint32_t decimation = 1) noexcept;
+#endif
+
 protected:
    /* --------------------------------------------------------------------------------------------------------
     * Information */
@@ -599,9 +711,10 @@ protected:
 
    /**
       Initialize the parameter @a index.@n
-      This function will be called once, shortly after the plugin is created.
+      This function will be called once, shortly after the plugin is created.@n
+      Not used if the plugin was constructed with a ParameterDescriptor table.
     */
-    virtual void initParameter(uint32_t index, Parameter& parameter) = 0;
+    virtual void initParameter(uint32_t index, Parameter& parameter);
 
 #if DISTRHO_PLUGIN_WANT_PROGRAMS
    /**
@@ -693,6 +806,20 @@ protected:
     virtual void run(const float** inputs, float** outputs, uint32_t frames) = 0;
 #endif
 
+#if DISTRHO_PLUGIN_WANT_INLINE_DISPLAY
+   /* --------------------------------------------------------------------------------------------------------
+    * Inline display */
+
+   /**
+      Render the inline display into @a image, which is allocated by the host side and sized as requested by the host.@n
+      The image can be made smaller by lowering its width and height, but never bigger.@n
+      This function is called from a non-realtime thread a limited number of times per second, while run() keeps being called,
+      so any DSP data it reads must be shared in a lock-free way, for example with a TripleBuffer.@n
+      Must be implemented by your plugin class only if DISTRHO_PLUGIN_WANT_INLINE_DISPLAY is enabled.
+    */
+    virtual void renderInlineDisplay(InlineDisplayImage& image) = 0;
+#endif
+
    /* --------------------------------------------------------------------------------------------------------
     * Callbacks (optional) */
 
@@ -712,6 +839,26 @@ protected:
     */
     virtual void sampleRateChanged(double newSampleRate);
 
+   /**
+      Optional callback to prepare for a buffer size and/or sample rate change while the plugin keeps processing.@n
+      This function is called from a non-realtime thread, possibly while run() is being called.
+      Allocate and set up whatever the new configuration needs here, without touching what run() is currently using,
+      then return true to have the new resources swapped in by applyConfiguration() right before the next run() call.
+      Returning false (the default) makes the host fall back to deactivate, bufferSizeChanged() and/or sampleRateChanged(), and activate.@n
+      Resources made obsolete by a previous swap can safely be freed here.
+      @note Only the JACK standalone uses this, other formats always deactivate the plugin.
+      @see applyConfiguration()
+    */
+    virtual bool prepareConfiguration(uint32_t newBufferSize, double newSampleRate);
+
+   /**
+      Optional callback to switch to the resources set up in a successful prepareConfiguration() call.@n
+      This function is called from the audio thread right before run(), so it must be realtime safe.
+      getBufferSize() and getSampleRate() already return the new values when this is called.
+      @see prepareConfiguration(uint32_t, double)
+    */
+    virtual void applyConfiguration();
+
     // -------------------------------------------------------------------------------------------------------
 
 private:
@@ -98,13 +98,24 @@ public:
     void sendNote(uint8_t channel, uint8_t note, uint8_t velocity);
 #endif
 
+#if DISTRHO_PLUGIN_WANT_UI_STREAM
+   /**
+      Read data written by the plugin with Plugin::writeUIStream().@n
+      Up to @a count values are copied into @a data, returns the number of values read.@n
+      Data not read in time is dropped by the plugin side, so call this regularly, for example during uiIdle().
+      @note The stream is not supported in the DSSI plugin format, where this always returns 0.
+    */
+    uint32_t readUIStream(float* data, uint32_t count);
+#endif
+
 #if DISTRHO_PLUGIN_WANT_DIRECT_ACCESS
    /* --------------------------------------------------------------------------------------------------------
     * Direct DSP access - DO NOT USE THIS UNLESS STRICTLY NECESSARY!! */
 
    /**
       getPluginInstancePointer.
-      @TODO Document this.
+      The plugin keeps running while the %UI reads from this pointer,
+      use a TripleBuffer (see extra/TripleBuffer.hpp) to share data that must not be torn.
     */
     void* getPluginInstancePointer() const noexcept;
 #endif
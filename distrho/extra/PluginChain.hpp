@@ -0,0 +1,719 @@
+/*
+ * DISTRHO Plugin Framework (DPF)
+ * Copyright (C) 2012-2016 Filipe Coelho <falktx@falktx.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with
+ * or without fee is hereby granted, provided that the above copyright notice and this
+ * permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+ * TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+ * NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef DISTRHO_PLUGIN_CHAIN_HPP_INCLUDED
+#define DISTRHO_PLUGIN_CHAIN_HPP_INCLUDED
+
+#include "../src/DistrhoPluginInternal.hpp"
+#include "Thread.hpp"
+
+#include <sched.h>
+
+#if DISTRHO_PLUGIN_NUM_INPUTS == 0 || DISTRHO_PLUGIN_NUM_INPUTS != DISTRHO_PLUGIN_NUM_OUTPUTS
+# error PluginChain requires the same number of audio inputs and outputs
+#endif
+
+#ifdef DISTRHO_PLUGIN_NUM_PARAMETERS
+# error PluginChain cannot be used with DISTRHO_PLUGIN_NUM_PARAMETERS, chained plugins have their own parameter counts
+#endif
+
+START_NAMESPACE_DISTRHO
+
+// -----------------------------------------------------------------------
+// PluginChain class
+
+/*
+ * Static processing graph of several plugins, run inside a single exported plugin.
+ *
+ * The graph is a list of stages processed in order.
+ * A serial stage is a single plugin, fed with the output of the previous stage.
+ * A parallel stage has several branches that all get the same input, their outputs are summed.
+ *
+ * Stages read the previous stage output in-place and alternate between 2 scratch buffers,
+ * the last stage writes directly into the host outputs, so no audio is copied between plugins.
+ * Branches of parallel stages can optionally be run on worker threads, see startWorkers().
+ *
+ * Typical usage is a plugin class owning the chain and forwarding its calls to it:
+ *
+ *   class ChannelStrip : public Plugin
+ *   {
+ *   public:
+ *       ChannelStrip()
+ *           : Plugin(kParameterCount, 0, 0), // sum of the parameter counts of all chained plugins
+ *             fChain(this)
+ *       {
+ *           fChain.addSerial(new EqPlugin(), "eq");
+ *           fChain.addSerial(new CompressorPlugin(), "comp");
+ *           fChain.addSerial(new LimiterPlugin(), "limiter");
+ *       }
+ *
+ *       void initParameter(uint32_t index, Parameter& parameter) override
+ *       {
+ *           fChain.initParameter(index, parameter);
+ *       }
+ *
+ *       void run(const float** inputs, float** outputs, uint32_t frames) override
+ *       {
+ *           fChain.run(inputs, outputs, frames);
+ *           setLatency(fChain.getLatency());
+ *       }
+ *
+ *       // getParameterValue, setParameterValue, activate, deactivate,
+ *       // bufferSizeChanged and sampleRateChanged forward to the chain too
+ *   };
+ *
+ * All chained plugins are built with the same DistrhoPluginInfo.h as the exported one,
+ * so they share its audio port count and its program, state, MIDI and time position support.
+ * Chained plugin programs, states and MIDI output are not exposed by the chain.
+ * Latency is summed over serial stages, parallel stages report their longest branch
+ * but do not compensate the others.
+ */
+class PluginChain
+{
+public:
+    static const uint32_t kMaxNodes        = 32;
+    static const uint32_t kMaxBranches     = 8;
+    static const uint32_t kNumChannels     = DISTRHO_PLUGIN_NUM_OUTPUTS;
+
+    /*
+     * Constructor.
+     * @a owner is the exported plugin, chained plugins get their time position from it.
+     * The position is resolved once per block on the audio thread, then given to every chained plugin.
+     */
+    PluginChain(const Plugin* const owner = nullptr)
+        : fOwner(owner),
+          fNodeCount(0),
+          fStageCount(0),
+          fMaxBranches(1),
+          fBufferSize(0),
+          fBufferData(nullptr),
+          fWorkerCount(0),
+          fWorkerSchedResolved(false),
+          fWorkerSchedPolicy(0),
+          fWorkerSchedSerial(0),
+          fJobClaims(0),
+          fJobDone(0),
+          fJobStage(0),
+          fJobFrames(0)
+#if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+        , fJobMidiEvents(nullptr),
+          fJobMidiEventCount(0)
+#endif
+    {
+        std::memset(fNodes, 0, sizeof(fNodes));
+        std::memset(fWorkers, 0, sizeof(fWorkers));
+        std::memset(&fWorkerSchedParam, 0, sizeof(fWorkerSchedParam));
+        std::memset(fJobInputs, 0, sizeof(fJobInputs));
+
+        _allocateBuffers(d_lastBufferSize);
+    }
+
+    /*
+     * Destructor.
+     */
+    ~PluginChain()
+    {
+        stopWorkers();
+
+        for (uint32_t i=0; i < fNodeCount; ++i)
+            delete fNodes[i];
+
+        delete[] fBufferData;
+    }
+
+    // -------------------------------------------------------------------
+    // graph setup, only valid before processing starts
+
+    /*
+     * Append a serial stage, taking ownership of @a plugin.
+     * Parameter symbols of @a plugin get @a symbolPrefix and an underscore prepended.
+     */
+    bool addSerial(Plugin* const plugin, const char* const symbolPrefix)
+    {
+        return addParallel(&plugin, &symbolPrefix, 1);
+    }
+
+    /*
+     * Append a parallel stage with @a count branches, taking ownership of all @a plugins.
+     */
+    bool addParallel(Plugin* const* const plugins, const char* const* const symbolPrefixes, const uint32_t count)
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(plugins != nullptr && symbolPrefixes != nullptr, false);
+        DISTRHO_SAFE_ASSERT_RETURN(count > 0 && count <= kMaxBranches, false);
+        DISTRHO_SAFE_ASSERT_RETURN(fNodeCount + count <= kMaxNodes, false);
+
+        Stage& stage(fStages[fStageCount++]);
+        stage.first = fNodeCount;
+        stage.count = count;
+
+        for (uint32_t i=0; i < count; ++i)
+        {
+            DISTRHO_SAFE_ASSERT_CONTINUE(plugins[i] != nullptr);
+
+            Node* const node = new Node(plugins[i], symbolPrefixes[i]);
+            node->parameterOffset = getParameterCount();
+
+            fNodes[fNodeCount++] = node;
+        }
+
+        // nodes that failed to be created are not part of the stage
+        stage.count = fNodeCount - stage.first;
+
+        if (stage.count == 0)
+        {
+            --fStageCount;
+            return false;
+        }
+
+        if (stage.count > fMaxBranches)
+        {
+            fMaxBranches = stage.count;
+            _allocateBuffers(fBufferSize);
+        }
+
+        return true;
+    }
+
+    /*
+     * Start @a count worker threads for running the branches of parallel stages.
+     * The calling thread always processes branches too, so workers are never waited for
+     * unless they already started on a branch.
+     * Workers take over the scheduling policy and priority of the thread calling run(),
+     * so the audio thread never waits for a lower priority thread.
+     * This needs the same realtime permissions as the host audio thread, a warning is printed otherwise.
+     */
+    bool startWorkers(const uint32_t count)
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(fWorkerCount == 0, false);
+        DISTRHO_SAFE_ASSERT_RETURN(count < kMaxBranches, false);
+
+        for (uint32_t i=0; i < count; ++i)
+        {
+            Worker* const worker = new Worker(*this);
+
+            if (! worker->startThread())
+            {
+                delete worker;
+                return false;
+            }
+
+            fWorkers[fWorkerCount++] = worker;
+        }
+
+        return true;
+    }
+
+    /*
+     * Stop all worker threads.
+     */
+    void stopWorkers()
+    {
+        for (uint32_t i=0; i < fWorkerCount; ++i)
+        {
+            fWorkers[i]->stop();
+            delete fWorkers[i];
+            fWorkers[i] = nullptr;
+        }
+
+        fWorkerCount = 0;
+    }
+
+    // -------------------------------------------------------------------
+    // parameters, indexes are over all chained plugins in order
+
+    uint32_t getParameterCount() const noexcept
+    {
+        uint32_t count = 0;
+
+        for (uint32_t i=0; i < fNodeCount; ++i)
+            count += fNodes[i]->plugin.getParameterCount();
+
+        return count;
+    }
+
+    void initParameter(const uint32_t index, Parameter& parameter) const
+    {
+        uint32_t rindex;
+        const Node* const node = _findNode(index, rindex);
+        DISTRHO_SAFE_ASSERT_RETURN(node != nullptr,);
+
+        parameter.hints  = node->plugin.getParameterHints(rindex);
+        parameter.name   = node->plugin.getParameterName(rindex);
+        parameter.symbol = node->symbolPrefix + node->plugin.getParameterSymbol(rindex).buffer();
+        parameter.unit   = node->plugin.getParameterUnit(rindex);
+        parameter.ranges = node->plugin.getParameterRanges(rindex);
+    }
+
+    float getParameterValue(const uint32_t index) const
+    {
+        uint32_t rindex;
+        const Node* const node = _findNode(index, rindex);
+        DISTRHO_SAFE_ASSERT_RETURN(node != nullptr, 0.0f);
+
+        return node->plugin.getParameterValue(rindex);
+    }
+
+    void setParameterValue(const uint32_t index, const float value)
+    {
+        uint32_t rindex;
+        Node* const node = const_cast<Node*>(_findNode(index, rindex));
+        DISTRHO_SAFE_ASSERT_RETURN(node != nullptr,);
+
+        node->plugin.setParameterValue(rindex, value);
+    }
+
+    // -------------------------------------------------------------------
+    // host state
+
+#if DISTRHO_PLUGIN_WANT_LATENCY
+    uint32_t getLatency() const noexcept
+    {
+        uint32_t latency = 0;
+
+        for (uint32_t s=0; s < fStageCount; ++s)
+        {
+            const Stage& stage(fStages[s]);
+            uint32_t stageLatency = 0;
+
+            for (uint32_t i=stage.first, end=stage.first+stage.count; i < end; ++i)
+            {
+                if (fNodes[i]->plugin.getLatency() > stageLatency)
+                    stageLatency = fNodes[i]->plugin.getLatency();
+            }
+
+            latency += stageLatency;
+        }
+
+        return latency;
+    }
+#endif
+
+    void activate()
+    {
+        // the host may process from a different thread after re-activation
+        fWorkerSchedResolved = false;
+
+        for (uint32_t i=0; i < fNodeCount; ++i)
+            fNodes[i]->plugin.activate();
+    }
+
+    void deactivate()
+    {
+        for (uint32_t i=0; i < fNodeCount; ++i)
+            fNodes[i]->plugin.deactivateIfNeeded();
+    }
+
+    void setBufferSize(const uint32_t bufferSize)
+    {
+        _allocateBuffers(bufferSize);
+
+        for (uint32_t i=0; i < fNodeCount; ++i)
+            fNodes[i]->plugin.setBufferSize(bufferSize, true);
+    }
+
+    void setSampleRate(const double sampleRate)
+    {
+        for (uint32_t i=0; i < fNodeCount; ++i)
+            fNodes[i]->plugin.setSampleRate(sampleRate, true);
+    }
+
+    // -------------------------------------------------------------------
+    // processing
+
+#if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+    /*
+     * Process all stages, every chained plugin gets the same MIDI events.
+     * Blocks bigger than the current buffer size are split.
+     */
+    void run(const float** const inputs, float** const outputs, const uint32_t frames,
+             const MidiEvent* const midiEvents, const uint32_t midiEventCount)
+#else
+    /*
+     * Process all stages.
+     * Blocks bigger than the current buffer size are split.
+     */
+    void run(const float** const inputs, float** const outputs, const uint32_t frames)
+#endif
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(inputs != nullptr && outputs != nullptr,);
+        DISTRHO_SAFE_ASSERT_RETURN(fBufferSize > 0,);
+
+        const float* chunkInputs[kNumChannels];
+        float*       chunkOutputs[kNumChannels];
+
+        for (uint32_t offset=0, chunk; offset < frames; offset += chunk)
+        {
+            chunk = frames - offset;
+
+            if (chunk > fBufferSize)
+                chunk = fBufferSize;
+
+            for (uint32_t c=0; c < kNumChannels; ++c)
+            {
+                chunkInputs[c]  = inputs[c] + offset;
+                chunkOutputs[c] = outputs[c] + offset;
+            }
+
+#if DISTRHO_PLUGIN_WANT_TIMEPOS
+            _updateTimePosition(offset);
+#endif
+
+#if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+            if (offset == 0 && chunk == frames)
+            {
+                _runChunk(chunkInputs, chunkOutputs, chunk, midiEvents, midiEventCount);
+                continue;
+            }
+
+            uint32_t chunkMidiEventCount = 0;
+
+            for (uint32_t i=0; i < midiEventCount && chunkMidiEventCount < kMaxMidiEvents; ++i)
+            {
+                if (midiEvents[i].frame < offset || midiEvents[i].frame >= offset + chunk)
+                    continue;
+
+                fMidiEvents[chunkMidiEventCount] = midiEvents[i];
+                fMidiEvents[chunkMidiEventCount++].frame -= offset;
+            }
+
+            _runChunk(chunkInputs, chunkOutputs, chunk, fMidiEvents, chunkMidiEventCount);
+#else
+            _runChunk(chunkInputs, chunkOutputs, chunk);
+#endif
+        }
+    }
+
+private:
+    // -------------------------------------------------------------------
+    // graph data
+
+    struct Node {
+        PluginExporter plugin;
+        String         symbolPrefix;
+        uint32_t       parameterOffset;
+
+        Node(Plugin* const p, const char* const prefix)
+            : plugin(nullptr, nullptr, nullptr, p),
+              symbolPrefix(prefix),
+              parameterOffset(0)
+        {
+            if (symbolPrefix.isNotEmpty())
+                symbolPrefix += "_";
+        }
+
+        DISTRHO_DECLARE_NON_COPY_STRUCT(Node)
+    };
+
+    struct Stage {
+        uint32_t first;
+        uint32_t count;
+    };
+
+    const Plugin* const fOwner;
+
+    Node*    fNodes[kMaxNodes];
+    uint32_t fNodeCount;
+    Stage    fStages[kMaxNodes];
+    uint32_t fStageCount;
+    uint32_t fMaxBranches;
+
+    // 2 buffer sets for serial stages, then one per branch of the widest parallel stage
+    uint32_t fBufferSize;
+    float*   fBufferData;
+    float*   fStageBuffers[2][kNumChannels];
+    float*   fBranchBuffers[kMaxBranches][kNumChannels];
+
+#if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+    MidiEvent fMidiEvents[kMaxMidiEvents];
+#endif
+
+    const Node* _findNode(const uint32_t index, uint32_t& rindex) const noexcept
+    {
+        for (uint32_t i=fNodeCount; i-- > 0;)
+        {
+            if (index < fNodes[i]->parameterOffset)
+                continue;
+
+            rindex = index - fNodes[i]->parameterOffset;
+            return rindex < fNodes[i]->plugin.getParameterCount() ? fNodes[i] : nullptr;
+        }
+
+        return nullptr;
+    }
+
+    void _allocateBuffers(const uint32_t bufferSize)
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(bufferSize > 0,);
+
+        delete[] fBufferData;
+
+        fBufferSize = bufferSize;
+        fBufferData = new float[(2 + fMaxBranches) * kNumChannels * bufferSize];
+
+        float* buffer = fBufferData;
+
+        for (uint32_t i=0; i < 2; ++i)
+            for (uint32_t c=0; c < kNumChannels; ++c, buffer += bufferSize)
+                fStageBuffers[i][c] = buffer;
+
+        for (uint32_t i=0; i < kMaxBranches; ++i)
+            for (uint32_t c=0; c < kNumChannels; ++c)
+                fBranchBuffers[i][c] = nullptr;
+
+        for (uint32_t i=0; i < fMaxBranches; ++i)
+            for (uint32_t c=0; c < kNumChannels; ++c, buffer += bufferSize)
+                fBranchBuffers[i][c] = buffer;
+    }
+
+    // -------------------------------------------------------------------
+    // processing
+
+#if DISTRHO_PLUGIN_WANT_TIMEPOS
+    // called on the audio thread, branches running on workers must never query the owner themselves
+    void _updateTimePosition(const uint32_t offset)
+    {
+        if (fOwner == nullptr)
+            return;
+
+        const TimePosition timePosition(fOwner->getTimePosition(offset));
+
+        for (uint32_t i=0; i < fNodeCount; ++i)
+            fNodes[i]->plugin.setTimePosition(timePosition);
+    }
+#endif
+
+#if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+    void _runChunk(const float** inputs, float** const outputs, const uint32_t frames,
+                   const MidiEvent* const midiEvents, const uint32_t midiEventCount)
+#else
+    void _runChunk(const float** inputs, float** const outputs, const uint32_t frames)
+#endif
+    {
+        if (fStageCount == 0)
+        {
+            for (uint32_t c=0; c < kNumChannels; ++c)
+            {
+                if (outputs[c] != inputs[c])
+                    std::memcpy(outputs[c], inputs[c], sizeof(float)*frames);
+            }
+            return;
+        }
+
+        for (uint32_t s=0; s < fStageCount; ++s)
+        {
+            const Stage& stage(fStages[s]);
+            float** const stageOutputs = (s+1 == fStageCount) ? outputs : fStageBuffers[s & 1];
+
+            if (stage.count == 1)
+            {
+#if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+                fNodes[stage.first]->plugin.run(inputs, stageOutputs, frames, midiEvents, midiEventCount);
+#else
+                fNodes[stage.first]->plugin.run(inputs, stageOutputs, frames);
+#endif
+            }
+            else
+            {
+#if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+                _runBranches(stage, inputs, frames, midiEvents, midiEventCount);
+#else
+                _runBranches(stage, inputs, frames);
+#endif
+
+                for (uint32_t c=0; c < kNumChannels; ++c)
+                {
+                    float* const out = stageOutputs[c];
+
+                    std::memcpy(out, fBranchBuffers[0][c], sizeof(float)*frames);
+
+                    for (uint32_t b=1; b < stage.count; ++b)
+                    {
+                        const float* const in = fBranchBuffers[b][c];
+
+                        for (uint32_t i=0; i < frames; ++i)
+                            out[i] += in[i];
+                    }
+                }
+            }
+
+            inputs = const_cast<const float**>(stageOutputs);
+        }
+    }
+
+    // -------------------------------------------------------------------
+    // parallel branches
+    //
+    // Branches are claimed through a single atomic word holding the branch count of the current job
+    // in the upper 16 bits and the next branch to process in the lower 16 bits,
+    // so a claim always sees a consistent job even when racing with the next one.
+    // A zero word means no job is open.
+
+    class Worker : public Thread
+    {
+    public:
+        Worker(PluginChain& chain)
+            : Thread("PluginChain"),
+              fChain(chain),
+              fWakeSignal() {}
+
+        void wake()
+        {
+            fWakeSignal.signal();
+        }
+
+        void stop()
+        {
+            signalThreadShouldExit();
+            fWakeSignal.signal();
+            stopThread(-1);
+        }
+
+    protected:
+        void run() override
+        {
+            uint32_t schedSerial = 0;
+
+            while (! shouldThreadExit())
+            {
+                fWakeSignal.wait();
+
+                if (shouldThreadExit())
+                    break;
+
+                fChain._applyWorkerScheduling(schedSerial);
+                fChain._processClaimedBranches();
+            }
+        }
+
+    private:
+        PluginChain& fChain;
+        Signal fWakeSignal;
+    };
+
+    Worker*  fWorkers[kMaxBranches];
+    uint32_t fWorkerCount;
+
+    // scheduling of the audio thread, copied by the workers.
+    // written by the audio thread before waking them, the serial changes each time.
+    bool        fWorkerSchedResolved;
+    int         fWorkerSchedPolicy;
+    sched_param fWorkerSchedParam;
+    uint32_t    fWorkerSchedSerial;
+
+    uint32_t fJobClaims;
+    uint32_t fJobDone;
+    uint32_t fJobStage;
+    uint32_t fJobFrames;
+    const float* fJobInputs[kNumChannels];
+#if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+    const MidiEvent* fJobMidiEvents;
+    uint32_t         fJobMidiEventCount;
+#endif
+
+#if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+    void _runBranches(const Stage& stage, const float** const inputs, const uint32_t frames,
+                      const MidiEvent* const midiEvents, const uint32_t midiEventCount)
+#else
+    void _runBranches(const Stage& stage, const float** const inputs, const uint32_t frames)
+#endif
+    {
+        if (fWorkerCount == 0)
+        {
+            for (uint32_t b=0; b < stage.count; ++b)
+            {
+#if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+                fNodes[stage.first+b]->plugin.run(inputs, fBranchBuffers[b], frames, midiEvents, midiEventCount);
+#else
+                fNodes[stage.first+b]->plugin.run(inputs, fBranchBuffers[b], frames);
+#endif
+            }
+            return;
+        }
+
+        if (! fWorkerSchedResolved)
+        {
+            fWorkerSchedResolved = true;
+
+            if (pthread_getschedparam(pthread_self(), &fWorkerSchedPolicy, &fWorkerSchedParam) == 0)
+                __atomic_add_fetch(&fWorkerSchedSerial, 1, __ATOMIC_RELEASE);
+        }
+
+        fJobStage  = stage.first;
+        fJobFrames = frames;
+        std::memcpy(fJobInputs, inputs, sizeof(fJobInputs));
+#if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+        fJobMidiEvents     = midiEvents;
+        fJobMidiEventCount = midiEventCount;
+#endif
+        __atomic_store_n(&fJobDone, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&fJobClaims, stage.count << 16, __ATOMIC_RELEASE);
+
+        for (uint32_t i=0; i < fWorkerCount && i+1 < stage.count; ++i)
+            fWorkers[i]->wake();
+
+        _processClaimedBranches();
+
+        // only waits for branches that a worker already started.
+        // workers run at the same priority, yielding lets one that shares this core finish
+        while (__atomic_load_n(&fJobDone, __ATOMIC_ACQUIRE) != stage.count)
+            sched_yield();
+
+        __atomic_store_n(&fJobClaims, 0, __ATOMIC_RELAXED);
+    }
+
+    // called on the worker threads
+    void _applyWorkerScheduling(uint32_t& serial)
+    {
+        const uint32_t current = __atomic_load_n(&fWorkerSchedSerial, __ATOMIC_ACQUIRE);
+
+        if (current == serial)
+            return;
+
+        serial = current;
+
+        if (pthread_setschedparam(pthread_self(), fWorkerSchedPolicy, &fWorkerSchedParam) != 0)
+            d_stderr2("PluginChain: cannot give worker threads the audio thread priority, parallel stages may cause xruns");
+    }
+
+    void _processClaimedBranches()
+    {
+        for (;;)
+        {
+            const uint32_t claim  = __atomic_fetch_add(&fJobClaims, 1, __ATOMIC_ACQ_REL);
+            const uint32_t branch = claim & 0xffff;
+
+            if (branch >= (claim >> 16))
+                return;
+
+#if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+            fNodes[fJobStage+branch]->plugin.run(fJobInputs, fBranchBuffers[branch], fJobFrames,
+                                                 fJobMidiEvents, fJobMidiEventCount);
+#else
+            fNodes[fJobStage+branch]->plugin.run(fJobInputs, fBranchBuffers[branch], fJobFrames);
+#endif
+
+            __atomic_add_fetch(&fJobDone, 1, __ATOMIC_RELEASE);
+        }
+    }
+
+    DISTRHO_DECLARE_NON_COPY_CLASS(PluginChain)
+};
+
+// -----------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
+
+#endif // DISTRHO_PLUGIN_CHAIN_HPP_INCLUDED
@@ -0,0 +1,186 @@
+/*
+ * DISTRHO Plugin Framework (DPF)
+ * Copyright (C) 2012-2016 Filipe Coelho <falktx@falktx.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with
+ * or without fee is hereby granted, provided that the above copyright notice and this
+ * permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+ * TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+ * NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef DISTRHO_RING_BUFFER_HPP_INCLUDED
+#define DISTRHO_RING_BUFFER_HPP_INCLUDED
+
+#include "../DistrhoUtils.hpp"
+
+START_NAMESPACE_DISTRHO
+
+// -----------------------------------------------------------------------
+// RingBuffer class
+
+/*
+ * Wait-free ring buffer, for a single writer and a single reader thread.
+ *
+ * The storage is allocated once in the constructor, rounded up to a power of 2.
+ * Writing and reading never allocate memory, block or spin, which makes this safe
+ * to use from the audio thread on either side.
+ */
+template <class T>
+class RingBuffer
+{
+public:
+    /*
+     * Constructor, reserving space for at least @a size elements.
+     */
+    RingBuffer(const uint32_t size)
+        : fSize(d_nextPowerOf2(size)),
+          fMask(fSize - 1),
+          fBuffer(new T[fSize]),
+          fHead(0),
+          fTail(0) {}
+
+    /*
+     * Destructor.
+     */
+    ~RingBuffer()
+    {
+        delete[] fBuffer;
+    }
+
+    /*
+     * Get the total number of elements this ring buffer can hold.
+     */
+    uint32_t getSize() const noexcept
+    {
+        return fSize;
+    }
+
+    /*
+     * Get the number of elements available for reading.
+     */
+    uint32_t getReadSpace() const noexcept
+    {
+        return __atomic_load_n(&fHead, __ATOMIC_ACQUIRE) - fTail;
+    }
+
+    /*
+     * Get the number of elements that can be written.
+     */
+    uint32_t getWriteSpace() const noexcept
+    {
+        return fSize - (fHead - __atomic_load_n(&fTail, __ATOMIC_ACQUIRE));
+    }
+
+    // -------------------------------------------------------------------
+    // writer side
+
+    /*
+     * Write up to @a count elements, taking every @a stride element from @a data.
+     * Returns the number of elements written, which is less than @a count if the buffer is full.
+     */
+    uint32_t write(const T* const data, uint32_t count, const uint32_t stride = 1) noexcept
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(data != nullptr, 0);
+        DISTRHO_SAFE_ASSERT_RETURN(stride != 0, 0);
+
+        const uint32_t space = getWriteSpace();
+
+        if (count > space)
+            count = space;
+
+        for (uint32_t i=0, j=fHead; i<count; ++i, ++j)
+            fBuffer[j & fMask] = data[i*stride];
+
+        __atomic_store_n(&fHead, fHead + count, __ATOMIC_RELEASE);
+        return count;
+    }
+
+    /*
+     * Write a single element.
+     * Returns false if the buffer is full.
+     */
+    bool put(const T& value) noexcept
+    {
+        if (getWriteSpace() == 0)
+            return false;
+
+        fBuffer[fHead & fMask] = value;
+        __atomic_store_n(&fHead, fHead + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+
+    // -------------------------------------------------------------------
+    // reader side
+
+    /*
+     * Read up to @a count elements into @a data.
+     * Returns the number of elements read.
+     */
+    uint32_t read(T* const data, uint32_t count) noexcept
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(data != nullptr, 0);
+
+        const uint32_t space = getReadSpace();
+
+        if (count > space)
+            count = space;
+
+        for (uint32_t i=0, j=fTail; i<count; ++i, ++j)
+            data[i] = fBuffer[j & fMask];
+
+        __atomic_store_n(&fTail, fTail + count, __ATOMIC_RELEASE);
+        return count;
+    }
+
+    /*
+     * Read a single element.
+     * Returns false if the buffer is empty.
+     */
+    bool get(T& value) noexcept
+    {
+        if (getReadSpace() == 0)
+            return false;
+
+        value = fBuffer[fTail & fMask];
+        __atomic_store_n(&fTail, fTail + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+
+    /*
+     * Discard up to @a count elements.
+     * Returns the number of elements discarded.
+     */
+    uint32_t skip(uint32_t count) noexcept
+    {
+        const uint32_t space = getReadSpace();
+
+        if (count > space)
+            count = space;
+
+        __atomic_store_n(&fTail, fTail + count, __ATOMIC_RELEASE);
+        return count;
+    }
+
+private:
+    const uint32_t fSize;
+    const uint32_t fMask;
+    T* const fBuffer;
+
+    uint32_t fHead; // write position, only changed by the writer
+    uint32_t fTail; // read position, only changed by the reader
+
+    DISTRHO_PREVENT_HEAP_ALLOCATION
+    DISTRHO_DECLARE_NON_COPY_CLASS(RingBuffer)
+};
+
+// -----------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
+
+#endif // DISTRHO_RING_BUFFER_HPP_INCLUDED
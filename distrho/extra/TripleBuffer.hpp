@@ -0,0 +1,140 @@
+/*
+ * DISTRHO Plugin Framework (DPF)
+ * Copyright (C) 2012-2016 Filipe Coelho <falktx@falktx.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with
+ * or without fee is hereby granted, provided that the above copyright notice and this
+ * permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+ * TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+ * NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef DISTRHO_TRIPLE_BUFFER_HPP_INCLUDED
+#define DISTRHO_TRIPLE_BUFFER_HPP_INCLUDED
+
+#include "../DistrhoUtils.hpp"
+
+START_NAMESPACE_DISTRHO
+
+// -----------------------------------------------------------------------
+// TripleBuffer class
+
+/*
+ * Lock-free snapshot of a data structure, shared between one writer and one reader thread.
+ *
+ * The writer fills the buffer returned by getWriteBuffer() and calls publish(), typically
+ * once at the end of each Plugin::run() call.
+ * The reader calls read() and gets the most recently published data, which stays untouched
+ * by the writer until the next read() call.
+ * Neither side ever blocks or waits on the other, and the data can never be torn.
+ *
+ * This is meant for plugins using DISTRHO_PLUGIN_WANT_DIRECT_ACCESS, where the UI reads
+ * meter or analyser data out of the plugin instance while run() is being called:
+ *
+ *   // plugin side, inside run()
+ *   MeterData& meters(fMeters.getWriteBuffer());
+ *   meters.peak = ...;
+ *   fMeters.publish();
+ *
+ *   // UI side, inside uiIdle()
+ *   MyPlugin* const plugin = (MyPlugin*)getPluginInstancePointer();
+ *   const MeterData& meters(plugin->fMeters.read());
+ *
+ * The type must be copy-assignable, as the constructor initializes all 3 buffers.
+ * Nothing is allocated after construction.
+ */
+template <class T>
+class TripleBuffer
+{
+public:
+    /*
+     * Constructor.
+     */
+    TripleBuffer() noexcept
+        : fWriteIndex(0),
+          fMiddleIndex(1),
+          fReadIndex(2),
+          fBuffers() {}
+
+    /*
+     * Constructor, using @a value as initial data for all buffers.
+     */
+    TripleBuffer(const T& value) noexcept
+        : fWriteIndex(0),
+          fMiddleIndex(1),
+          fReadIndex(2),
+          fBuffers()
+    {
+        fBuffers[0] = fBuffers[1] = fBuffers[2] = value;
+    }
+
+    // -------------------------------------------------------------------
+    // writer side
+
+    /*
+     * Get the buffer to be written into.
+     * Its contents are from 2 publish() calls ago, or older.
+     */
+    T& getWriteBuffer() noexcept
+    {
+        return fBuffers[fWriteIndex];
+    }
+
+    /*
+     * Publish the contents of the write buffer, making it available to the reader.
+     * The next call to getWriteBuffer() will return a different buffer.
+     */
+    void publish() noexcept
+    {
+        const int old = __atomic_exchange_n(&fMiddleIndex, fWriteIndex | kNewDataFlag, __ATOMIC_ACQ_REL);
+        fWriteIndex = old & kIndexMask;
+    }
+
+    // -------------------------------------------------------------------
+    // reader side
+
+    /*
+     * Check if new data has been published since the last read() call.
+     */
+    bool hasNewData() const noexcept
+    {
+        return (__atomic_load_n(&fMiddleIndex, __ATOMIC_ACQUIRE) & kNewDataFlag) != 0;
+    }
+
+    /*
+     * Get the most recently published data.
+     * The returned reference is valid until the next read() call.
+     */
+    const T& read() noexcept
+    {
+        if (hasNewData())
+        {
+            const int old = __atomic_exchange_n(&fMiddleIndex, fReadIndex, __ATOMIC_ACQ_REL);
+            fReadIndex = old & kIndexMask;
+        }
+
+        return fBuffers[fReadIndex];
+    }
+
+private:
+    static const int kIndexMask   = 0x3;
+    static const int kNewDataFlag = 0x4;
+
+    int fWriteIndex;  // only touched by the writer
+    int fMiddleIndex; // shared, index plus new data flag
+    int fReadIndex;   // only touched by the reader
+    T   fBuffers[3];
+
+    DISTRHO_DECLARE_NON_COPY_CLASS(TripleBuffer)
+};
+
+// -----------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
+
+#endif // DISTRHO_TRIPLE_BUFFER_HPP_INCLUDED
@@ -0,0 +1,578 @@
+/*
+ * DISTRHO Plugin Framework (DPF)
+ * Copyright (C) 2012-2016 Filipe Coelho <falktx@falktx.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with
+ * or without fee is hereby granted, provided that the above copyright notice and this
+ * permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+ * TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+ * NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef DISTRHO_VOICE_ENGINE_HPP_INCLUDED
+#define DISTRHO_VOICE_ENGINE_HPP_INCLUDED
+
+#include "../DistrhoPlugin.hpp"
+
+#include <cmath>
+#include <cstring>
+
+START_NAMESPACE_DISTRHO
+
+// -----------------------------------------------------------------------
+// Voice stealing policies
+
+enum VoiceStealingPolicy {
+    kVoiceStealNone = 0, // new notes are dropped when all voices are in use
+    kVoiceStealOldest,   // steal the voice that was started first
+    kVoiceStealQuietest, // steal the voice with the lowest level
+    kVoiceStealLowest,   // steal the voice playing the lowest note
+    kVoiceStealHighest   // steal the voice playing the highest note
+};
+
+// -----------------------------------------------------------------------
+// Voice states
+
+enum VoiceState {
+    kVoiceIdle = 0,    // voice is free
+    kVoiceHeld,        // note is being held down
+    kVoiceSustained,   // note was released while the sustain pedal is down
+    kVoiceReleased     // note was released, voice plays until stopVoice() is called
+};
+
+// -----------------------------------------------------------------------
+// VoiceEngine class
+
+/*
+ * Polyphonic voice engine for synth plugins.
+ *
+ * Voice state is kept as a structure of arrays, all statically sized to @a kMaxVoices,
+ * so no memory is allocated after construction and the per-voice DSP loops of the subclass
+ * can run over contiguous memory.
+ * Inactive voices always have a zero gain, which lets the subclass process whole lanes
+ * without branching on the voice state.
+ *
+ * The engine itself contains no SIMD code. Lanes are only padding of the voice arrays to a
+ * multiple of kVoiceLanes, so that plain loops over getVoiceRenderCount() voices can be
+ * auto-vectorised by the compiler (e.g. -O3 -ffast-math with SSE2 or NEON enabled).
+ * Whether that happens depends on the subclass loops and compiler flags.
+ *
+ * Typical usage inside a DISTRHO_PLUGIN_IS_SYNTH plugin is:
+ *
+ *   class MySynth : public Plugin,
+ *                   public VoiceEngine<32>
+ *   {
+ *       void run(const float**, float** outputs, uint32_t frames,
+ *                const MidiEvent* midiEvents, uint32_t midiEventCount) override
+ *       {
+ *           processVoices(outputs, frames, midiEvents, midiEventCount);
+ *       }
+ *
+ *       void renderVoices(float** outputs, uint32_t frames) override
+ *       {
+ *           const uint32_t count = getVoiceRenderCount();
+ *
+ *           for (uint32_t i=0; i<frames; ++i)
+ *               for (uint32_t v=0; v<count; ++v)
+ *                   outputs[0][i] += fVoiceGain[v] * ...;
+ *       }
+ *   };
+ *
+ * The engine splits each block at the MIDI event offsets, so renderVoices() is called
+ * with output pointers already offset to the current sub-block.
+ */
+template <uint32_t kMaxVoices>
+class VoiceEngine
+{
+public:
+    /*
+     * Number of voices in a lane, matching 4 floats of a 128-bit vector register.
+     * The voice count is rounded up to a multiple of this value, no explicit SIMD is used.
+     */
+    static const uint32_t kVoiceLanes = 4;
+    static const uint32_t kVoiceCount = ((kMaxVoices + kVoiceLanes - 1) / kVoiceLanes) * kVoiceLanes;
+
+    /*
+     * Constructor.
+     */
+    VoiceEngine(const VoiceStealingPolicy policy = kVoiceStealOldest) noexcept
+        : fPolicy(policy),
+          fVoiceLimit(kMaxVoices),
+          fVoiceRenderCount(0),
+          fVoiceSerial(0),
+          fSustain(0),
+          fPitchBendRange(2.0f)
+    {
+        std::memset(fVoiceState,     0, sizeof(fVoiceState));
+        std::memset(fVoiceNote,      0, sizeof(fVoiceNote));
+        std::memset(fVoiceChannel,   0, sizeof(fVoiceChannel));
+        std::memset(fVoiceAge,       0, sizeof(fVoiceAge));
+
+        for (uint32_t v=0; v<kVoiceCount; ++v)
+        {
+            fVoiceGain[v]      = 0.0f;
+            fVoiceVelocity[v]  = 0.0f;
+            fVoicePitch[v]     = 0.0f;
+            fVoiceFrequency[v] = 0.0f;
+            fVoiceLevel[v]     = 0.0f;
+        }
+
+        for (uint8_t c=0; c<16; ++c)
+            fPitchBend[c] = 0.0f;
+    }
+
+    /*
+     * Destructor.
+     */
+    virtual ~VoiceEngine() {}
+
+    // -------------------------------------------------------------------
+
+    /*
+     * Get the current voice stealing policy.
+     */
+    VoiceStealingPolicy getStealingPolicy() const noexcept
+    {
+        return fPolicy;
+    }
+
+    /*
+     * Change the voice stealing policy.
+     */
+    void setStealingPolicy(const VoiceStealingPolicy policy) noexcept
+    {
+        fPolicy = policy;
+    }
+
+    /*
+     * Get the maximum number of voices that can play at the same time.
+     */
+    uint32_t getVoiceLimit() const noexcept
+    {
+        return fVoiceLimit;
+    }
+
+    /*
+     * Change the maximum number of voices that can play at the same time.
+     * Voices above the new limit are stopped immediately.
+     */
+    void setVoiceLimit(const uint32_t limit) noexcept
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(limit > 0 && limit <= kMaxVoices,);
+
+        fVoiceLimit = limit;
+
+        for (uint32_t v=limit; v<kVoiceCount; ++v)
+        {
+            if (fVoiceState[v] != kVoiceIdle)
+                stopVoice(v);
+        }
+    }
+
+    /*
+     * Set the pitch bend range in semitones, used to compute the voice pitches.
+     */
+    void setPitchBendRange(const float semitones) noexcept
+    {
+        fPitchBendRange = semitones;
+
+        for (uint32_t v=0; v<kVoiceCount; ++v)
+            _updateVoicePitch(v);
+    }
+
+    /*
+     * Get the number of voices currently playing.
+     */
+    uint32_t getActiveVoiceCount() const noexcept
+    {
+        uint32_t count = 0;
+
+        for (uint32_t v=0; v<kVoiceCount; ++v)
+        {
+            if (fVoiceState[v] != kVoiceIdle)
+                ++count;
+        }
+
+        return count;
+    }
+
+    /*
+     * Get the number of voices that need to be rendered.
+     * This is the highest active voice index rounded up to a multiple of kVoiceLanes,
+     * voices within this range that are idle have a zero gain.
+     */
+    uint32_t getVoiceRenderCount() const noexcept
+    {
+        return fVoiceRenderCount;
+    }
+
+    // -------------------------------------------------------------------
+
+    /*
+     * Process a block of audio.
+     * Clears the output buffers, then renders all voices while handling the MIDI events
+     * at their exact frame offsets.
+     */
+    void processVoices(float** const outputs, const uint32_t frames,
+                       const MidiEvent* const midiEvents, const uint32_t midiEventCount)
+    {
+        float* bufs[DISTRHO_PLUGIN_NUM_OUTPUTS > 0 ? DISTRHO_PLUGIN_NUM_OUTPUTS : 1];
+
+        for (uint32_t i=0; i<DISTRHO_PLUGIN_NUM_OUTPUTS; ++i)
+            std::memset(outputs[i], 0, sizeof(float)*frames);
+
+        uint32_t offset = 0;
+
+        for (uint32_t i=0; i<midiEventCount; ++i)
+        {
+            const MidiEvent& midiEvent(midiEvents[i]);
+
+            if (midiEvent.frame > offset && midiEvent.frame <= frames)
+            {
+                _render(outputs, bufs, offset, midiEvent.frame - offset);
+                offset = midiEvent.frame;
+            }
+
+            processMidiEvent(midiEvent);
+        }
+
+        if (offset < frames)
+            _render(outputs, bufs, offset, frames - offset);
+    }
+
+    /*
+     * Handle a single MIDI event.
+     * Called by processVoices(), only needed if the subclass handles MIDI itself.
+     */
+    void processMidiEvent(const MidiEvent& midiEvent) noexcept
+    {
+        if (midiEvent.size > MidiEvent::kDataSize || midiEvent.size < 2)
+            return;
+
+        const uint8_t status  = midiEvent.data[0] & 0xF0;
+        const uint8_t channel = midiEvent.data[0] & 0x0F;
+        const uint8_t data1   = midiEvent.data[1] & 0x7F;
+        const uint8_t data2   = midiEvent.size > 2 ? midiEvent.data[2] & 0x7F : 0;
+
+        switch (status)
+        {
+        case 0x90:
+            if (data2 != 0)
+            {
+                noteOn(channel, data1, data2);
+                break;
+            }
+            // fall through
+        case 0x80:
+            noteOff(channel, data1);
+            break;
+        case 0xB0:
+            switch (data1)
+            {
+            case 64: // sustain pedal
+                setSustain(channel, data2 >= 64);
+                break;
+            case 120: // all sound off
+                allNotesOff(true);
+                break;
+            case 123: // all notes off
+                allNotesOff(false);
+                break;
+            }
+            break;
+        case 0xE0:
+            fPitchBend[channel] = float((int(data2) << 7 | data1) - 8192) / 8192.0f;
+
+            for (uint32_t v=0; v<kVoiceCount; ++v)
+            {
+                if (fVoiceState[v] != kVoiceIdle && fVoiceChannel[v] == channel)
+                    _updateVoicePitch(v);
+            }
+            break;
+        }
+    }
+
+    /*
+     * Start a note, allocating or stealing a voice according to the stealing policy.
+     * Returns the voice index, or -1 if no voice was available.
+     */
+    int32_t noteOn(const uint8_t channel, const uint8_t note, const uint8_t velocity) noexcept
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(channel < 16, -1);
+        DISTRHO_SAFE_ASSERT_RETURN(note < 128, -1);
+
+        uint32_t voice = kVoiceCount;
+
+        // retrigger the same note if it is still playing
+        for (uint32_t v=0; v<fVoiceLimit; ++v)
+        {
+            if (fVoiceState[v] != kVoiceIdle && fVoiceNote[v] == note && fVoiceChannel[v] == channel)
+            {
+                voice = v;
+                break;
+            }
+        }
+
+        // find a free voice
+        if (voice == kVoiceCount)
+        {
+            for (uint32_t v=0; v<fVoiceLimit; ++v)
+            {
+                if (fVoiceState[v] == kVoiceIdle)
+                {
+                    voice = v;
+                    break;
+                }
+            }
+        }
+
+        // steal one
+        if (voice == kVoiceCount)
+        {
+            voice = _findVoiceToSteal();
+
+            if (voice == kVoiceCount)
+                return -1;
+
+            voiceStolen(voice);
+        }
+
+        fVoiceState[voice]    = kVoiceHeld;
+        fVoiceNote[voice]     = note;
+        fVoiceChannel[voice]  = channel;
+        fVoiceAge[voice]      = ++fVoiceSerial;
+        fVoiceGain[voice]     = 1.0f;
+        fVoiceVelocity[voice] = float(velocity) / 127.0f;
+        _updateVoicePitch(voice);
+
+        if (voice >= fVoiceRenderCount)
+            fVoiceRenderCount = ((voice + kVoiceLanes) / kVoiceLanes) * kVoiceLanes;
+
+        voiceStarted(voice);
+        return int32_t(voice);
+    }
+
+    /*
+     * Release a note.
+     * The voice keeps playing until stopVoice() is called, typically when its release envelope ends.
+     */
+    void noteOff(const uint8_t channel, const uint8_t note) noexcept
+    {
+        for (uint32_t v=0; v<kVoiceCount; ++v)
+        {
+            if (fVoiceState[v] != kVoiceHeld || fVoiceNote[v] != note || fVoiceChannel[v] != channel)
+                continue;
+
+            if (fSustain & (1 << channel))
+            {
+                fVoiceState[v] = kVoiceSustained;
+            }
+            else
+            {
+                fVoiceState[v] = kVoiceReleased;
+                voiceReleased(v);
+            }
+        }
+    }
+
+    /*
+     * Change the sustain pedal state of a MIDI channel.
+     */
+    void setSustain(const uint8_t channel, const bool sustain) noexcept
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(channel < 16,);
+
+        if (sustain)
+        {
+            fSustain |= (1 << channel);
+            return;
+        }
+
+        fSustain &= ~(1 << channel);
+
+        for (uint32_t v=0; v<kVoiceCount; ++v)
+        {
+            if (fVoiceState[v] == kVoiceSustained && fVoiceChannel[v] == channel)
+            {
+                fVoiceState[v] = kVoiceReleased;
+                voiceReleased(v);
+            }
+        }
+    }
+
+    /*
+     * Release all notes, or stop all voices immediately if @a immediate is true.
+     */
+    void allNotesOff(const bool immediate) noexcept
+    {
+        fSustain = 0;
+
+        for (uint32_t v=0; v<kVoiceCount; ++v)
+        {
+            if (fVoiceState[v] == kVoiceIdle)
+                continue;
+
+            if (immediate)
+            {
+                stopVoice(v);
+            }
+            else if (fVoiceState[v] != kVoiceReleased)
+            {
+                fVoiceState[v] = kVoiceReleased;
+                voiceReleased(v);
+            }
+        }
+    }
+
+    /*
+     * Stop a voice and return it to the pool.
+     * Subclasses call this when a released voice has finished playing.
+     */
+    void stopVoice(const uint32_t voice) noexcept
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(voice < kVoiceCount,);
+
+        fVoiceState[voice] = kVoiceIdle;
+        fVoiceGain[voice]  = 0.0f;
+        fVoiceLevel[voice] = 0.0f;
+
+        if (voice + kVoiceLanes < fVoiceRenderCount)
+            return;
+
+        // shrink the render range
+        uint32_t count = 0;
+
+        for (uint32_t v=0; v<fVoiceRenderCount; ++v)
+        {
+            if (fVoiceState[v] != kVoiceIdle)
+                count = ((v + kVoiceLanes) / kVoiceLanes) * kVoiceLanes;
+        }
+
+        fVoiceRenderCount = count;
+    }
+
+protected:
+    // -------------------------------------------------------------------
+    // Voice callbacks
+
+    /*
+     * Render all voices into @a outputs for @a frames frames, adding to the existing output.
+     * Only the first getVoiceRenderCount() voices need to be processed.
+     */
+    virtual void renderVoices(float** outputs, uint32_t frames) = 0;
+
+    /*
+     * A voice has been started, reset its DSP state here.
+     */
+    virtual void voiceStarted(uint32_t) {}
+
+    /*
+     * A voice has been released, start its release stage here.
+     */
+    virtual void voiceReleased(uint32_t) {}
+
+    /*
+     * A voice is about to be stolen and restarted with a new note.
+     */
+    virtual void voiceStolen(uint32_t) {}
+
+    // -------------------------------------------------------------------
+    // Voice data, as structure of arrays
+
+    VoiceState fVoiceState[kVoiceCount];
+    uint8_t    fVoiceNote[kVoiceCount];
+    uint8_t    fVoiceChannel[kVoiceCount];
+    uint32_t   fVoiceAge[kVoiceCount];
+
+    float fVoiceGain[kVoiceCount];      // 1 for active voices, 0 for idle ones
+    float fVoiceVelocity[kVoiceCount];  // 0 to 1
+    float fVoicePitch[kVoiceCount];     // note + pitch bend, in semitones
+    float fVoiceFrequency[kVoiceCount]; // in Hz
+    float fVoiceLevel[kVoiceCount];     // current output level, written by the subclass for kVoiceStealQuietest
+
+private:
+    VoiceStealingPolicy fPolicy;
+    uint32_t fVoiceLimit;
+    uint32_t fVoiceRenderCount;
+    uint32_t fVoiceSerial;
+    uint16_t fSustain;
+    float    fPitchBend[16];
+    float    fPitchBendRange;
+
+    void _render(float** const outputs, float** const bufs, const uint32_t offset, const uint32_t frames)
+    {
+        if (fVoiceRenderCount == 0)
+            return;
+
+        for (uint32_t i=0; i<DISTRHO_PLUGIN_NUM_OUTPUTS; ++i)
+            bufs[i] = outputs[i] + offset;
+
+        renderVoices(bufs, frames);
+    }
+
+    void _updateVoicePitch(const uint32_t voice) noexcept
+    {
+        fVoicePitch[voice]     = float(fVoiceNote[voice]) + fPitchBend[fVoiceChannel[voice]] * fPitchBendRange;
+        fVoiceFrequency[voice] = 440.0f * std::pow(2.0f, (fVoicePitch[voice] - 69.0f) / 12.0f);
+    }
+
+    uint32_t _findVoiceToSteal() const noexcept
+    {
+        if (fPolicy == kVoiceStealNone)
+            return kVoiceCount;
+
+        uint32_t voice = kVoiceCount;
+
+        // prefer voices that have been released, then any other voice
+        for (int pass=0; pass<2 && voice == kVoiceCount; ++pass)
+        {
+            for (uint32_t v=0; v<fVoiceLimit; ++v)
+            {
+                if (pass == 0 && fVoiceState[v] != kVoiceReleased)
+                    continue;
+
+                if (voice == kVoiceCount)
+                {
+                    voice = v;
+                    continue;
+                }
+
+                bool better;
+
+                switch (fPolicy)
+                {
+                case kVoiceStealQuietest:
+                    better = fVoiceLevel[v] < fVoiceLevel[voice];
+                    break;
+                case kVoiceStealLowest:
+                    better = fVoiceNote[v] < fVoiceNote[voice];
+                    break;
+                case kVoiceStealHighest:
+                    better = fVoiceNote[v] > fVoiceNote[voice];
+                    break;
+                default:
+                    better = fVoiceAge[v] < fVoiceAge[voice];
+                    break;
+                }
+
+                if (better)
+                    voice = v;
+            }
+        }
+
+        return voice;
+    }
+
+    DISTRHO_DECLARE_NON_COPY_CLASS(VoiceEngine)
+};
+
+// -----------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
+
+#endif // DISTRHO_VOICE_ENGINE_HPP_INCLUDED
@@ -31,39 +31,50 @@ const String          PluginExporter::sFallbackString;
 const AudioPort       PluginExporter::sFallbackAudioPort;
 const ParameterRanges PluginExporter::sFallbackRanges;
 
+#if DISTRHO_PLUGIN_WANT_SHARED_METADATA
+/* ------------------------------------------------------------------------------------------------------------
+ * Shared metadata, see DistrhoPluginInternal.hpp */
+
+PluginSharedMetadata PluginExporter::sSharedMetadata;
+#endif
+
 /* ------------------------------------------------------------------------------------------------------------
  * Plugin */
 
 Plugin::Plugin(uint32_t parameterCount, uint32_t programCount, uint32_t stateCount)
     : pData(new PrivateData())
 {
-#if DISTRHO_PLUGIN_NUM_INPUTS+DISTRHO_PLUGIN_NUM_OUTPUTS > 0
-    pData->audioPorts = new AudioPort[DISTRHO_PLUGIN_NUM_INPUTS+DISTRHO_PLUGIN_NUM_OUTPUTS];
+    pData->parameterCount = parameterCount;
+
+#if DISTRHO_PLUGIN_WANT_PROGRAMS
+    pData->programCount = programCount;
+#else
+    DISTRHO_SAFE_ASSERT(programCount == 0);
 #endif
 
-    if (parameterCount > 0)
-    {
-        pData->parameterCount = parameterCount;
-        pData->parameters     = new Parameter[parameterCount];
-    }
+#if DISTRHO_PLUGIN_WANT_STATE
+    pData->stateCount = stateCount;
+#else
+    DISTRHO_SAFE_ASSERT(stateCount == 0);
+#endif
+}
+
+Plugin::Plugin(const ParameterDescriptor* parameters, uint32_t parameterCount, uint32_t programCount, uint32_t stateCount)
+    : pData(new PrivateData())
+{
+    DISTRHO_SAFE_ASSERT_RETURN(parameters != nullptr || parameterCount == 0,);
+
+    pData->parameterCount       = parameterCount;
+    pData->parameterDescriptors = parameters;
 
 #if DISTRHO_PLUGIN_WANT_PROGRAMS
-    if (programCount > 0)
-    {
-        pData->programCount = programCount;
-        pData->programNames = new String[programCount];
-    }
+    pData->programCount = programCount;
 #else
     DISTRHO_SAFE_ASSERT(programCount == 0);
 #endif
 
 #if DISTRHO_PLUGIN_WANT_STATE
-    if (stateCount > 0)
-    {
-        pData->stateCount     = stateCount;
-        pData->stateKeys      = new String[stateCount];
-        pData->stateDefValues = new String[stateCount];
-    }
+    pData->stateCount = stateCount;
 #else
     DISTRHO_SAFE_ASSERT(stateCount == 0);
 #endif
@@ -90,7 +101,44 @@ double Plugin::getSampleRate() const noexcept
 #if DISTRHO_PLUGIN_WANT_TIMEPOS
 const TimePosition& Plugin::getTimePosition() const noexcept
 {
-    return pData->timePosition;
+    pData->updateTimePositionIfNeeded();
+
+    return pData->timePosition.getPosition();
+}
+
+TimePosition Plugin::getTimePosition(const uint32_t frame) const noexcept
+{
+    pData->updateTimePositionIfNeeded();
+
+    TimePosition timePosition;
+    pData->timePosition.getPositionAt(timePosition, frame, pData->sampleRate);
+    return timePosition;
+}
+
+void Plugin::getBeatPhase(float* const phase, const uint32_t frames, const double beatsPerCycle) const noexcept
+{
+    DISTRHO_SAFE_ASSERT_RETURN(phase != nullptr,);
+    DISTRHO_SAFE_ASSERT_RETURN(beatsPerCycle > 0.0,);
+
+    pData->updateTimePositionIfNeeded();
+
+    const TimePositionExtrapolator& timePosition(pData->timePosition);
+
+    if (! timePosition.getPosition().bbt.valid)
+    {
+        std::memset(phase, 0, sizeof(float)*frames);
+        return;
+    }
+
+    const double start = std::fmod(timePosition.getBeat() / beatsPerCycle, 1.0);
+    const double step  = timePosition.getBeatsPerFrame(pData->sampleRate) / beatsPerCycle;
+
+    // no dependency between iterations, lets the compiler vectorize
+    for (uint32_t i=0; i < frames; ++i)
+    {
+        const double value = start + step * i;
+        phase[i] = static_cast<float>(value - std::floor(value));
+    }
 }
 #endif
 
@@ -102,10 +150,37 @@ void Plugin::setLatency(uint32_t frames) noexcept
 #endif
 
 #if DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
-bool Plugin::writeMidiEvent(const MidiEvent& /*midiEvent*/) noexcept
+bool Plugin::writeMidiEvent(const MidiEvent& midiEvent) noexcept
 {
-    // TODO
+    return pData->writeMidiCallback(midiEvent);
+}
+#endif
+
+#if DISTRHO_PLUGIN_WANT_UI_STREAM
+bool Plugin::writeUIStream(const float* const data, const uint32_t count, const uint32_t decimation) noexcept
+{
+    DISTRHO_SAFE_ASSERT_RETURN(data != nullptr, false);
+    DISTRHO_SAFE_ASSERT_RETURN(decimation != 0, false);
+
+# if DISTRHO_PLUGIN_USE_UI_STREAM
+    const uint32_t phase = pData->uiStreamPhase;
+
+    if (phase >= count)
+    {
+        pData->uiStreamPhase -= count;
+        return true;
+    }
+
+    const uint32_t valueCount = (count - phase + decimation - 1) / decimation;
+
+    pData->uiStreamPhase = phase + valueCount * decimation - count;
+
+    return pData->uiStream.write(data + phase, valueCount, decimation) == valueCount;
+# else
+    // no UI in this build or plugin format to read the stream
+    (void)count;
     return false;
+# endif
 }
 #endif
 
@@ -130,12 +205,17 @@ void Plugin::initAudioPort(bool input, uint32_t index, AudioPort& port)
     }
 }
 
+void Plugin::initParameter(uint32_t, Parameter&) {}
+
 /* ------------------------------------------------------------------------------------------------------------
  * Callbacks (optional) */
 
 void Plugin::bufferSizeChanged(uint32_t) {}
 void Plugin::sampleRateChanged(double)   {}
 
+bool Plugin::prepareConfiguration(uint32_t, double) { return false; }
+void Plugin::applyConfiguration() {}
+
 // -----------------------------------------------------------------------------------------------------------
 
 END_NAMESPACE_DISTRHO
@@ -44,6 +44,9 @@ public:
         : fHost(host),
           fUI(this, 0, editParameterCallback, setParameterCallback, setStateCallback, sendNoteCallback, setSizeCallback, plugin->getInstancePointer())
     {
+#if DISTRHO_PLUGIN_USE_UI_STREAM
+        fUI.setUIStream(plugin->getUIStream());
+#endif
         fUI.setWindowTitle(host->uiName);
 
         if (host->uiParentId != 0)
@@ -179,11 +182,24 @@ public:
     {
 #if DISTRHO_PLUGIN_HAS_UI
         fUiPtr = nullptr;
+#endif
+#if DISTRHO_PLUGIN_WANT_INLINE_DISPLAY
+        fInlineDisplayBuffer     = nullptr;
+        fInlineDisplayBufferSize = 0;
+        fInlineDisplayFrames     = 0;
 #endif
     }
 
     ~PluginCarla() override
     {
+#if DISTRHO_PLUGIN_WANT_INLINE_DISPLAY
+        if (fInlineDisplayBuffer != nullptr)
+        {
+            delete[] fInlineDisplayBuffer;
+            fInlineDisplayBuffer = nullptr;
+        }
+#endif
+
 #if DISTRHO_PLUGIN_HAS_UI
         if (fUiPtr != nullptr)
         {
@@ -317,34 +333,77 @@ protected:
         fPlugin.deactivate();
     }
 
-#if DISTRHO_PLUGIN_IS_SYNTH
+#if DISTRHO_PLUGIN_WANT_MIDI_INPUT
     void process(float** const inBuffer, float** const outBuffer, const uint32_t frames, const NativeMidiEvent* const midiEvents, const uint32_t midiEventCount) override
     {
-        MidiEvent realMidiEvents[midiEventCount];
+        uint32_t realMidiEventCount = 0;
 
-        for (uint32_t i=0; i < midiEventCount; ++i)
+        for (uint32_t i=0; i < midiEventCount && realMidiEventCount < kMaxMidiEvents; ++i)
         {
             const NativeMidiEvent& midiEvent(midiEvents[i]);
-            MidiEvent& realMidiEvent(realMidiEvents[i]);
 
-            realMidiEvent.frame = midiEvent.time;
-            realMidiEvent.size  = midiEvent.size;
+            // native events only carry short messages, there is no SysEx to forward
+            if (midiEvent.size == 0 || midiEvent.size > MidiEvent::kDataSize)
+                continue;
 
-            uint8_t j=0;
-            for (; j<midiEvent.size; ++j)
-                realMidiEvent.data[j] = midiEvent.data[j];
-            for (; j<midiEvent.size; ++j)
-                realMidiEvent.data[j] = midiEvent.data[j];
+            MidiEvent& realMidiEvent(fMidiEvents[realMidiEventCount++]);
 
+            realMidiEvent.frame   = midiEvent.time;
+            realMidiEvent.size    = midiEvent.size;
             realMidiEvent.dataExt = nullptr;
+            std::memcpy(realMidiEvent.data, midiEvent.data, midiEvent.size);
         }
 
-        fPlugin.run(const_cast<const float**>(inBuffer), outBuffer, frames, realMidiEvents, midiEventCount);
+        fPlugin.run(const_cast<const float**>(inBuffer), outBuffer, frames, fMidiEvents, realMidiEventCount);
+
+# if DISTRHO_PLUGIN_WANT_INLINE_DISPLAY
+        queueInlineDisplayIfNeeded(frames);
+# endif
     }
 #else
     void process(float** const inBuffer, float** const outBuffer, const uint32_t frames, const NativeMidiEvent* const, const uint32_t) override
     {
         fPlugin.run(const_cast<const float**>(inBuffer), outBuffer, frames);
+
+# if DISTRHO_PLUGIN_WANT_INLINE_DISPLAY
+        queueInlineDisplayIfNeeded(frames);
+# endif
+    }
+#endif
+
+#if DISTRHO_PLUGIN_WANT_INLINE_DISPLAY
+    // -------------------------------------------------------------------
+    // Plugin inline display calls
+
+    const NativeInlineDisplayImageSurface* renderInlineDisplay(const uint32_t width, const uint32_t height) override
+    {
+        CARLA_SAFE_ASSERT_RETURN(width > 0 && height > 0, nullptr);
+
+        // only grows, so steady redraws at the same size never allocate
+        const std::size_t size = static_cast<std::size_t>(width) * height * 4;
+
+        if (size > fInlineDisplayBufferSize)
+        {
+            delete[] fInlineDisplayBuffer;
+            fInlineDisplayBuffer     = new uint8_t[size];
+            fInlineDisplayBufferSize = size;
+        }
+
+        InlineDisplayImage image;
+        image.data   = fInlineDisplayBuffer;
+        image.width  = width;
+        image.height = height;
+        image.stride = width * 4;
+
+        fPlugin.renderInlineDisplay(image);
+
+        CARLA_SAFE_ASSERT_RETURN(image.width <= width && image.height <= height, nullptr);
+
+        fInlineDisplaySurface.data   = fInlineDisplayBuffer;
+        fInlineDisplaySurface.width  = static_cast<int>(image.width);
+        fInlineDisplaySurface.height = static_cast<int>(image.height);
+        fInlineDisplaySurface.stride = static_cast<int>(width * 4);
+        return &fInlineDisplaySurface;
     }
 #endif
 
@@ -441,6 +500,33 @@ protected:
 private:
     PluginExporter fPlugin;
 
+#if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+    // Temporary data
+    MidiEvent fMidiEvents[kMaxMidiEvents];
+#endif
+
+#if DISTRHO_PLUGIN_WANT_INLINE_DISPLAY
+    // Inline display, redrawn at most this many times per second
+    static const uint32_t kInlineDisplayRate = 30;
+
+    NativeInlineDisplayImageSurface fInlineDisplaySurface;
+    uint8_t*    fInlineDisplayBuffer;
+    std::size_t fInlineDisplayBufferSize;
+    uint32_t    fInlineDisplayFrames;
+
+    // called from the audio thread, the host only sets a flag and renders later in its idle loop
+    void queueInlineDisplayIfNeeded(const uint32_t frames)
+    {
+        fInlineDisplayFrames += frames;
+
+        if (fInlineDisplayFrames < static_cast<uint32_t>(fPlugin.getSampleRate()) / kInlineDisplayRate)
+            return;
+
+        fInlineDisplayFrames = 0;
+        hostQueueDrawInlineDisplay();
+    }
+#endif
+
 #if DISTRHO_PLUGIN_HAS_UI
     // UI
     UICarla* fUiPtr;
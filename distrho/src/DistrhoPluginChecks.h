@@ -85,6 +85,18 @@
 # define DISTRHO_PLUGIN_WANT_TIMEPOS 0
 #endif
 
+#ifndef DISTRHO_PLUGIN_WANT_SHARED_METADATA
+# define DISTRHO_PLUGIN_WANT_SHARED_METADATA 0
+#endif
+
+#ifndef DISTRHO_PLUGIN_WANT_UI_STREAM
+# define DISTRHO_PLUGIN_WANT_UI_STREAM 0
+#endif
+
+#ifndef DISTRHO_PLUGIN_WANT_INLINE_DISPLAY
+# define DISTRHO_PLUGIN_WANT_INLINE_DISPLAY 0
+#endif
+
 #ifndef DISTRHO_UI_USE_NANOVG
 # define DISTRHO_UI_USE_NANOVG 0
 #endif
@@ -107,6 +119,13 @@
 # define DISTRHO_UI_URI DISTRHO_PLUGIN_URI "#UI"
 #endif
 
+// -----------------------------------------------------------------------
+// Define DISTRHO_PLUGIN_UI_STREAM_SIZE if needed
+
+#ifndef DISTRHO_PLUGIN_UI_STREAM_SIZE
+# define DISTRHO_PLUGIN_UI_STREAM_SIZE 16384
+#endif
+
 // -----------------------------------------------------------------------
 // Test if synth has audio outputs
 
@@ -19,6 +19,21 @@
 
 #include "../DistrhoPlugin.hpp"
 
+#if DISTRHO_PLUGIN_WANT_SHARED_METADATA
+# include "../extra/Mutex.hpp"
+#endif
+
+// the UI stream is only allocated for wrappers that can run the UI in the same process
+#if DISTRHO_PLUGIN_WANT_UI_STREAM && DISTRHO_PLUGIN_HAS_UI && ! (defined(DISTRHO_PLUGIN_TARGET_LADSPA) || defined(DISTRHO_PLUGIN_TARGET_DSSI))
+# define DISTRHO_PLUGIN_USE_UI_STREAM 1
+#else
+# define DISTRHO_PLUGIN_USE_UI_STREAM 0
+#endif
+
+#if DISTRHO_PLUGIN_USE_UI_STREAM
+# include "../extra/RingBuffer.hpp"
+#endif
+
 START_NAMESPACE_DISTRHO
 
 // -----------------------------------------------------------------------
@@ -26,6 +41,193 @@ START_NAMESPACE_DISTRHO
 
 static const uint32_t kMaxMidiEvents = 512;
 
+#ifdef DISTRHO_PLUGIN_NUM_PARAMETERS
+// -----------------------------------------------------------------------
+// Parameter count known at compile time, allows wrappers to unroll parameter loops
+
+static const uint32_t kStaticParameterCount = DISTRHO_PLUGIN_NUM_PARAMETERS;
+#endif
+
+// -----------------------------------------------------------------------
+// Plugin callbacks
+
+typedef bool (*writeMidiFunc)     (void* ptr, const MidiEvent& midiEvent);
+typedef void (*updateTimePosFunc) (void* ptr);
+
+// -----------------------------------------------------------------------
+// MIDI helpers
+
+/*
+ * Check if a MIDI event is a note-off, including note-ons with zero velocity.
+ */
+static inline
+bool d_isMidiNoteOff(const MidiEvent& event) noexcept
+{
+    if (event.size != 3 || event.dataExt != nullptr)
+        return false;
+
+    const uint8_t status = event.data[0] & 0xF0;
+
+    return status == 0x80 || (status == 0x90 && event.data[2] == 0);
+}
+
+/*
+ * Stable in-place sort of MIDI events by frame.
+ * Events are usually in order or close to it, where insertion sort is the fastest.
+ */
+static inline
+void d_sortMidiEvents(MidiEvent* const events, const uint32_t count) noexcept
+{
+    for (uint32_t i=1; i < count; ++i)
+    {
+        if (events[i-1].frame <= events[i].frame)
+            continue;
+
+        const MidiEvent event(events[i]);
+        uint32_t j = i;
+
+        for (; j > 0 && events[j-1].frame > event.frame; --j)
+            events[j] = events[j-1];
+
+        events[j] = event;
+    }
+}
+
+#if DISTRHO_PLUGIN_WANT_TIMEPOS
+// -----------------------------------------------------------------------
+// Time position extrapolation
+
+/*
+ * Extrapolates a host time position at constant tempo.
+ *
+ * Keeps the beat position as a fraction, which the integer BBT fields in TimePosition cannot hold,
+ * so that advancing block after block does not accumulate rounding errors.
+ */
+class TimePositionExtrapolator
+{
+public:
+    TimePositionExtrapolator() noexcept
+        : fPosition(),
+          fBarBeat(0.0),
+          fBeatsPerMinute(0.0) {}
+
+    /*
+     * Set a new reference position, as received from the host.
+     * @a barBeat is the number of beats since the start of the bar, including the fractional part.
+     * @a beatsPerMinute is the rate at which @a barBeat advances, which for some hosts is not the same
+     * as the tempo reported in @a pos (e.g. VST tempo is in quarter notes).
+     */
+    void setPosition(const TimePosition& pos, const double barBeat, const double beatsPerMinute) noexcept
+    {
+        fPosition       = pos;
+        fBarBeat        = barBeat;
+        fBeatsPerMinute = beatsPerMinute;
+    }
+
+    /*
+     * Set a new reference position, as received from the host.
+     * The beat fraction is taken from the BBT tick.
+     */
+    void setPosition(const TimePosition& pos) noexcept
+    {
+        fPosition       = pos;
+        fBarBeat        = (pos.bbt.valid && pos.bbt.ticksPerBeat > 0.0)
+                        ? double(pos.bbt.beat - 1) + double(pos.bbt.tick) / pos.bbt.ticksPerBeat
+                        : 0.0;
+        fBeatsPerMinute = pos.bbt.beatsPerMinute;
+    }
+
+    const TimePosition& getPosition() const noexcept
+    {
+        return fPosition;
+    }
+
+    /*
+     * Get the number of beats since the start of the bar, including the fractional part.
+     */
+    double getBarBeat() const noexcept
+    {
+        return fBarBeat;
+    }
+
+    /*
+     * Get the number of beats since the start of the song, including the fractional part.
+     */
+    double getBeat() const noexcept
+    {
+        return double(fPosition.bbt.bar - 1) * fPosition.bbt.beatsPerBar + fBarBeat;
+    }
+
+    /*
+     * Get how many beats go by per audio frame, 0 if not playing.
+     */
+    double getBeatsPerFrame(const double sampleRate) const noexcept
+    {
+        if (! fPosition.playing || ! fPosition.bbt.valid || fBeatsPerMinute <= 0.0 || sampleRate <= 0.0)
+            return 0.0;
+
+        return fBeatsPerMinute / (60.0 * sampleRate);
+    }
+
+    /*
+     * Get the time position @a frames after the reference position.
+     */
+    void getPositionAt(TimePosition& pos, const uint32_t frames, const double sampleRate) const noexcept
+    {
+        pos = fPosition;
+
+        if (frames == 0 || ! fPosition.playing)
+            return;
+
+        double barBeat = fBarBeat;
+        _advance(pos, barBeat, fBeatsPerMinute, frames, sampleRate);
+    }
+
+    /*
+     * Move the reference position forward by @a frames.
+     */
+    void advance(const uint32_t frames, const double sampleRate) noexcept
+    {
+        if (frames == 0 || ! fPosition.playing)
+            return;
+
+        _advance(fPosition, fBarBeat, fBeatsPerMinute, frames, sampleRate);
+    }
+
+private:
+    TimePosition fPosition;
+    double fBarBeat;
+    double fBeatsPerMinute;
+
+    static void _advance(TimePosition& pos, double& barBeat, const double beatsPerMinute,
+                         const uint32_t frames, const double sampleRate) noexcept
+    {
+        pos.frame += frames;
+
+        TimePosition::BarBeatTick& bbt(pos.bbt);
+
+        if (! bbt.valid || beatsPerMinute <= 0.0 || bbt.beatsPerBar <= 0.0f || sampleRate <= 0.0)
+            return;
+
+        barBeat += double(frames) * beatsPerMinute / (60.0 * sampleRate);
+
+        if (barBeat >= bbt.beatsPerBar)
+        {
+            const double addedBars = std::floor(barBeat / bbt.beatsPerBar);
+
+            barBeat -= addedBars * bbt.beatsPerBar;
+            bbt.bar += static_cast<int32_t>(addedBars);
+            bbt.barStartTick = bbt.ticksPerBeat * bbt.beatsPerBar * (bbt.bar - 1);
+        }
+
+        const double rest = std::fmod(barBeat, 1.0);
+
+        bbt.beat = static_cast<int32_t>(barBeat - rest) + 1;
+        bbt.tick = static_cast<int32_t>(rest * bbt.ticksPerBeat);
+    }
+};
+#endif
+
 // -----------------------------------------------------------------------
 // Static data, see DistrhoPlugin.cpp
 
@@ -44,6 +246,7 @@ struct Plugin::PrivateData {
 
     uint32_t   parameterCount;
     Parameter* parameters;
+    const ParameterDescriptor* parameterDescriptors;
 
 #if DISTRHO_PLUGIN_WANT_PROGRAMS
     uint32_t programCount;
@@ -61,12 +264,31 @@ struct Plugin::PrivateData {
 #endif
 
 #if DISTRHO_PLUGIN_WANT_TIMEPOS
-    TimePosition timePosition;
+    TimePositionExtrapolator timePosition;
+    bool timePositionPending;
+#endif
+
+#if DISTRHO_PLUGIN_USE_UI_STREAM
+    RingBuffer<float> uiStream;
+    uint32_t uiStreamPhase;
+#endif
+
+    // Callbacks
+    void* callbacksPtr;
+#if DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
+    writeMidiFunc writeMidiCallbackFunc;
+#endif
+#if DISTRHO_PLUGIN_WANT_TIMEPOS
+    updateTimePosFunc updateTimePosCallbackFunc;
 #endif
 
     uint32_t bufferSize;
     double   sampleRate;
 
+#if DISTRHO_PLUGIN_WANT_SHARED_METADATA
+    bool sharedMetadata;
+#endif
+
     PrivateData() noexcept
         : isProcessing(false),
 #if DISTRHO_PLUGIN_NUM_INPUTS+DISTRHO_PLUGIN_NUM_OUTPUTS > 0
@@ -74,6 +296,7 @@ struct Plugin::PrivateData {
 #endif
           parameterCount(0),
           parameters(nullptr),
+          parameterDescriptors(nullptr),
 #if DISTRHO_PLUGIN_WANT_PROGRAMS
           programCount(0),
           programNames(nullptr),
@@ -85,9 +308,26 @@ struct Plugin::PrivateData {
 #endif
 #if DISTRHO_PLUGIN_WANT_LATENCY
           latency(0),
+#endif
+#if DISTRHO_PLUGIN_WANT_TIMEPOS
+          timePositionPending(false),
+#endif
+#if DISTRHO_PLUGIN_USE_UI_STREAM
+          uiStream(DISTRHO_PLUGIN_UI_STREAM_SIZE),
+          uiStreamPhase(0),
+#endif
+          callbacksPtr(nullptr),
+#if DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
+          writeMidiCallbackFunc(nullptr),
+#endif
+#if DISTRHO_PLUGIN_WANT_TIMEPOS
+          updateTimePosCallbackFunc(nullptr),
 #endif
           bufferSize(d_lastBufferSize),
           sampleRate(d_lastSampleRate)
+#if DISTRHO_PLUGIN_WANT_SHARED_METADATA
+        , sharedMetadata(false)
+#endif
     {
         DISTRHO_SAFE_ASSERT(bufferSize != 0);
         DISTRHO_SAFE_ASSERT(d_isNotZero(sampleRate));
@@ -95,6 +335,12 @@ struct Plugin::PrivateData {
 
     ~PrivateData() noexcept
     {
+#if DISTRHO_PLUGIN_WANT_SHARED_METADATA
+        // metadata is owned by PluginSharedMetadata
+        if (sharedMetadata)
+            return;
+#endif
+
 #if DISTRHO_PLUGIN_NUM_INPUTS+DISTRHO_PLUGIN_NUM_OUTPUTS > 0
         if (audioPorts != nullptr)
         {
@@ -131,7 +377,96 @@ struct Plugin::PrivateData {
         }
 #endif
     }
+
+#if DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
+    bool writeMidiCallback(const MidiEvent& midiEvent)
+    {
+        if (writeMidiCallbackFunc != nullptr)
+            return writeMidiCallbackFunc(callbacksPtr, midiEvent);
+
+        return false;
+    }
+#endif
+
+#if DISTRHO_PLUGIN_WANT_TIMEPOS
+    // fetch the time position from the host the first time the plugin asks for it during run()
+    void updateTimePositionIfNeeded()
+    {
+        if (! timePositionPending || ! isProcessing)
+            return;
+
+        timePositionPending = false;
+
+        if (updateTimePosCallbackFunc != nullptr)
+            updateTimePosCallbackFunc(callbacksPtr);
+    }
+#endif
+};
+
+#if DISTRHO_PLUGIN_WANT_SHARED_METADATA
+// -----------------------------------------------------------------------
+// Metadata shared between all plugin instances of the same binary.
+// Filled by the first PluginExporter, read-only afterwards.
+
+struct PluginSharedMetadata {
+    Mutex mutex;
+    bool  initialized;
+
+#if DISTRHO_PLUGIN_NUM_INPUTS+DISTRHO_PLUGIN_NUM_OUTPUTS > 0
+    AudioPort* audioPorts;
+#endif
+
+    uint32_t   parameterCount;
+    Parameter* parameters;
+
+#if DISTRHO_PLUGIN_WANT_PROGRAMS
+    uint32_t programCount;
+    String*  programNames;
+#endif
+
+#if DISTRHO_PLUGIN_WANT_STATE
+    uint32_t stateCount;
+    String*  stateKeys;
+    String*  stateDefValues;
+#endif
+
+    PluginSharedMetadata() noexcept
+        : mutex(),
+          initialized(false),
+#if DISTRHO_PLUGIN_NUM_INPUTS+DISTRHO_PLUGIN_NUM_OUTPUTS > 0
+          audioPorts(nullptr),
+#endif
+          parameterCount(0),
+          parameters(nullptr)
+#if DISTRHO_PLUGIN_WANT_PROGRAMS
+        , programCount(0),
+          programNames(nullptr)
+#endif
+#if DISTRHO_PLUGIN_WANT_STATE
+        , stateCount(0),
+          stateKeys(nullptr),
+          stateDefValues(nullptr)
+#endif
+    {}
+
+    ~PluginSharedMetadata() noexcept
+    {
+#if DISTRHO_PLUGIN_NUM_INPUTS+DISTRHO_PLUGIN_NUM_OUTPUTS > 0
+        delete[] audioPorts;
+#endif
+        delete[] parameters;
+#if DISTRHO_PLUGIN_WANT_PROGRAMS
+        delete[] programNames;
+#endif
+#if DISTRHO_PLUGIN_WANT_STATE
+        delete[] stateKeys;
+        delete[] stateDefValues;
+#endif
+    }
+
+    DISTRHO_DECLARE_NON_COPY_STRUCT(PluginSharedMetadata)
 };
+#endif
 
 // -----------------------------------------------------------------------
 // Plugin exporter class
@@ -139,15 +474,60 @@ struct Plugin::PrivateData {
 class PluginExporter
 {
 public:
-    PluginExporter()
-        : fPlugin(createPlugin()),
+    // an already created plugin can be given instead of calling createPlugin(), the exporter takes ownership of it.
+    // such plugins never use shared metadata, as they are not necessarily of the same class.
+    PluginExporter(void* const callbacksPtr = nullptr,
+                   const writeMidiFunc writeMidiCall = nullptr,
+                   const updateTimePosFunc updateTimePosCall = nullptr,
+                   Plugin* const plugin = nullptr)
+        : fPlugin(_validatePlugin((plugin != nullptr) ? plugin : createPlugin())),
           fData((fPlugin != nullptr) ? fPlugin->pData : nullptr),
-          fIsActive(false)
+          fIsActive(false),
+          fConfigurationState(kConfigurationIdle),
+          fPendingBufferSize(0),
+          fPendingSampleRate(0.0)
     {
         DISTRHO_SAFE_ASSERT_RETURN(fPlugin != nullptr,);
         DISTRHO_SAFE_ASSERT_RETURN(fData != nullptr,);
 
+        fData->callbacksPtr = callbacksPtr;
+#if DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
+        fData->writeMidiCallbackFunc = writeMidiCall;
+#else
+        // unused
+        (void)writeMidiCall;
+#endif
+#if DISTRHO_PLUGIN_WANT_TIMEPOS
+        fData->updateTimePosCallbackFunc = updateTimePosCall;
+#else
+        // unused
+        (void)updateTimePosCall;
+#endif
+
+#if DISTRHO_PLUGIN_WANT_SHARED_METADATA
+        const MutexLocker cml(sSharedMetadata.mutex);
+
+        if (plugin == nullptr && sSharedMetadata.initialized && _matchesSharedMetadata())
+        {
+# if DISTRHO_PLUGIN_NUM_INPUTS+DISTRHO_PLUGIN_NUM_OUTPUTS > 0
+            fData->audioPorts     = sSharedMetadata.audioPorts;
+# endif
+            fData->parameters     = sSharedMetadata.parameters;
+# if DISTRHO_PLUGIN_WANT_PROGRAMS
+            fData->programNames   = sSharedMetadata.programNames;
+# endif
+# if DISTRHO_PLUGIN_WANT_STATE
+            fData->stateKeys      = sSharedMetadata.stateKeys;
+            fData->stateDefValues = sSharedMetadata.stateDefValues;
+# endif
+            fData->sharedMetadata = true;
+            return;
+        }
+#endif
+
 #if DISTRHO_PLUGIN_NUM_INPUTS+DISTRHO_PLUGIN_NUM_OUTPUTS > 0
+        fData->audioPorts = new AudioPort[DISTRHO_PLUGIN_NUM_INPUTS+DISTRHO_PLUGIN_NUM_OUTPUTS];
+
         {
             uint32_t j=0;
 # if DISTRHO_PLUGIN_NUM_INPUTS > 0
@@ -161,18 +541,70 @@ public:
         }
 #endif
 
-        for (uint32_t i=0, count=fData->parameterCount; i < count; ++i)
-            fPlugin->initParameter(i, fData->parameters[i]);
+        if (fData->parameterCount > 0)
+            fData->parameters = new Parameter[fData->parameterCount];
+
+        if (const ParameterDescriptor* const descriptors = fData->parameterDescriptors)
+        {
+            for (uint32_t i=0, count=fData->parameterCount; i < count; ++i)
+            {
+                const ParameterDescriptor& desc(descriptors[i]);
+                Parameter& param(fData->parameters[i]);
+
+                param.hints  = desc.hints;
+                param.name   = desc.name;
+                param.symbol = desc.symbol;
+                param.unit   = desc.unit;
+                param.ranges = ParameterRanges(desc.def, desc.min, desc.max);
+            }
+        }
+        else
+        {
+            for (uint32_t i=0, count=fData->parameterCount; i < count; ++i)
+                fPlugin->initParameter(i, fData->parameters[i]);
+        }
 
 #if DISTRHO_PLUGIN_WANT_PROGRAMS
+        if (fData->programCount > 0)
+            fData->programNames = new String[fData->programCount];
+
         for (uint32_t i=0, count=fData->programCount; i < count; ++i)
             fPlugin->initProgramName(i, fData->programNames[i]);
 #endif
 
 #if DISTRHO_PLUGIN_WANT_STATE
+        if (fData->stateCount > 0)
+        {
+            fData->stateKeys      = new String[fData->stateCount];
+            fData->stateDefValues = new String[fData->stateCount];
+        }
+
         for (uint32_t i=0, count=fData->stateCount; i < count; ++i)
             fPlugin->initState(i, fData->stateKeys[i], fData->stateDefValues[i]);
 #endif
+
+#if DISTRHO_PLUGIN_WANT_SHARED_METADATA
+        if (plugin == nullptr && ! sSharedMetadata.initialized)
+        {
+            // hand over metadata of the first instance
+# if DISTRHO_PLUGIN_NUM_INPUTS+DISTRHO_PLUGIN_NUM_OUTPUTS > 0
+            sSharedMetadata.audioPorts     = fData->audioPorts;
+# endif
+            sSharedMetadata.parameterCount = fData->parameterCount;
+            sSharedMetadata.parameters     = fData->parameters;
+# if DISTRHO_PLUGIN_WANT_PROGRAMS
+            sSharedMetadata.programCount   = fData->programCount;
+            sSharedMetadata.programNames   = fData->programNames;
+# endif
+# if DISTRHO_PLUGIN_WANT_STATE
+            sSharedMetadata.stateCount     = fData->stateCount;
+            sSharedMetadata.stateKeys      = fData->stateKeys;
+            sSharedMetadata.stateDefValues = fData->stateDefValues;
+# endif
+            sSharedMetadata.initialized    = true;
+            fData->sharedMetadata          = true;
+        }
+#endif
     }
 
     ~PluginExporter()
@@ -182,6 +614,13 @@ public:
 
     // -------------------------------------------------------------------
 
+    // false if the plugin could not be created or does not match this build,
+    // wrappers must not use such an instance and fail instantiation instead
+    bool isValid() const noexcept
+    {
+        return fPlugin != nullptr;
+    }
+
     const char* getName() const noexcept
     {
         DISTRHO_SAFE_ASSERT_RETURN(fPlugin != nullptr, "");
@@ -278,9 +717,14 @@ public:
 
     uint32_t getParameterCount() const noexcept
     {
+#ifdef DISTRHO_PLUGIN_NUM_PARAMETERS
+        // plugins with a different count are rejected in the constructor
+        return (fData != nullptr) ? kStaticParameterCount : 0;
+#else
         DISTRHO_SAFE_ASSERT_RETURN(fData != nullptr, 0);
 
         return fData->parameterCount;
+#endif
     }
 
     uint32_t getParameterHints(const uint32_t index) const noexcept
@@ -424,7 +868,43 @@ public:
     {
         DISTRHO_SAFE_ASSERT_RETURN(fData != nullptr,);
 
-        std::memcpy(&fData->timePosition, &timePosition, sizeof(TimePosition));
+        fData->timePosition.setPosition(timePosition);
+        fData->timePositionPending = false;
+    }
+
+    void setTimePosition(const TimePositionExtrapolator& timePosition) noexcept
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(fData != nullptr,);
+
+        fData->timePosition = timePosition;
+        fData->timePositionPending = false;
+    }
+
+    // mark the time position as outdated, the update callback is called only if the plugin asks for it
+    void invalidateTimePosition() noexcept
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(fData != nullptr,);
+
+        fData->timePositionPending = true;
+    }
+#endif
+
+#if DISTRHO_PLUGIN_WANT_INLINE_DISPLAY
+    void renderInlineDisplay(InlineDisplayImage& image)
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(fPlugin != nullptr,);
+        DISTRHO_SAFE_ASSERT_RETURN(image.data != nullptr,);
+
+        fPlugin->renderInlineDisplay(image);
+    }
+#endif
+
+#if DISTRHO_PLUGIN_USE_UI_STREAM
+    RingBuffer<float>* getUIStream() const noexcept
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(fData != nullptr, nullptr);
+
+        return &fData->uiStream;
     }
 #endif
 
@@ -451,6 +931,7 @@ public:
 
         fIsActive = false;
         fPlugin->deactivate();
+        _applyPendingConfiguration();
     }
 
     void deactivateIfNeeded()
@@ -461,10 +942,11 @@ public:
         {
             fIsActive = false;
             fPlugin->deactivate();
+            _applyPendingConfiguration();
         }
     }
 
-#if DISTRHO_PLUGIN_IS_SYNTH
+#if DISTRHO_PLUGIN_WANT_MIDI_INPUT
     void run(const float** const inputs, float** const outputs, const uint32_t frames,
              const MidiEvent* const midiEvents, const uint32_t midiEventCount)
     {
@@ -477,6 +959,8 @@ public:
             fPlugin->activate();
         }
 
+        _applyPendingConfiguration();
+
         fData->isProcessing = true;
         fPlugin->run(inputs, outputs, frames, midiEvents, midiEventCount);
         fData->isProcessing = false;
@@ -493,6 +977,8 @@ public:
             fPlugin->activate();
         }
 
+        _applyPendingConfiguration();
+
         fData->isProcessing = true;
         fPlugin->run(inputs, outputs, frames);
         fData->isProcessing = false;
@@ -551,6 +1037,44 @@ public:
         }
     }
 
+    // Non-realtime side of a live reconfiguration, see Plugin::prepareConfiguration().
+    // Returns false if the plugin does not support it or is not active,
+    // in which case setBufferSize() and setSampleRate() must be used instead.
+    // A pending configuration gets replaced, so hosts must not call this while run()
+    // may already be processing blocks of the pending size.
+    bool prepareConfiguration(const uint32_t bufferSize, const double sampleRate)
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(fData != nullptr, false);
+        DISTRHO_SAFE_ASSERT_RETURN(fPlugin != nullptr, false);
+        DISTRHO_SAFE_ASSERT(bufferSize >= 2);
+        DISTRHO_SAFE_ASSERT(sampleRate > 0.0);
+
+        if (! fIsActive)
+            return false;
+
+        // take over the pending slot, cancelling a configuration that was not applied yet.
+        // the audio thread only holds it while calling applyConfiguration(), which is short.
+        for (int state = __atomic_load_n(&fConfigurationState, __ATOMIC_ACQUIRE);;)
+        {
+            if (state == kConfigurationApplying)
+                state = __atomic_load_n(&fConfigurationState, __ATOMIC_ACQUIRE);
+            else if (__atomic_compare_exchange_n(&fConfigurationState, &state, kConfigurationPreparing,
+                                                 false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+                break;
+        }
+
+        if (! fPlugin->prepareConfiguration(bufferSize, sampleRate))
+        {
+            __atomic_store_n(&fConfigurationState, kConfigurationIdle, __ATOMIC_RELEASE);
+            return false;
+        }
+
+        fPendingBufferSize = bufferSize;
+        fPendingSampleRate = sampleRate;
+        __atomic_store_n(&fConfigurationState, kConfigurationReady, __ATOMIC_RELEASE);
+        return true;
+    }
+
 private:
     // -------------------------------------------------------------------
     // Plugin and DistrhoPlugin data
@@ -559,6 +1083,52 @@ private:
     Plugin::PrivateData* const fData;
     bool fIsActive;
 
+    // -------------------------------------------------------------------
+    // Live reconfiguration, see prepareConfiguration()
+
+    static const int kConfigurationIdle      = 0;
+    static const int kConfigurationPreparing = 1;
+    static const int kConfigurationReady     = 2;
+    static const int kConfigurationApplying  = 3;
+
+    int      fConfigurationState;
+    uint32_t fPendingBufferSize;
+    double   fPendingSampleRate;
+
+    // takes ownership of the plugin, deleting it if it cannot be used by this build
+    static Plugin* _validatePlugin(Plugin* const plugin)
+    {
+#ifdef DISTRHO_PLUGIN_NUM_PARAMETERS
+        if (plugin != nullptr && plugin->pData->parameterCount != kStaticParameterCount)
+        {
+            d_stderr2("Plugin has %u parameters but DISTRHO_PLUGIN_NUM_PARAMETERS is %u, cannot continue!",
+                      plugin->pData->parameterCount, kStaticParameterCount);
+            delete plugin;
+            return nullptr;
+        }
+#endif
+
+        return plugin;
+    }
+
+    // called at block boundaries, swaps in a prepared configuration if there is one
+    void _applyPendingConfiguration()
+    {
+        int state = kConfigurationReady;
+
+        if (__atomic_load_n(&fConfigurationState, __ATOMIC_RELAXED) != kConfigurationReady)
+            return;
+        if (! __atomic_compare_exchange_n(&fConfigurationState, &state, kConfigurationApplying,
+                                          false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+            return;
+
+        fData->bufferSize = fPendingBufferSize;
+        fData->sampleRate = fPendingSampleRate;
+        fPlugin->applyConfiguration();
+
+        __atomic_store_n(&fConfigurationState, kConfigurationIdle, __ATOMIC_RELEASE);
+    }
+
     // -------------------------------------------------------------------
     // Static fallback data, see DistrhoPlugin.cpp
 
@@ -566,6 +1136,28 @@ private:
     static const AudioPort       sFallbackAudioPort;
     static const ParameterRanges sFallbackRanges;
 
+#if DISTRHO_PLUGIN_WANT_SHARED_METADATA
+    // -------------------------------------------------------------------
+    // Shared metadata, see DistrhoPlugin.cpp
+
+    static PluginSharedMetadata sSharedMetadata;
+
+    bool _matchesSharedMetadata() const noexcept
+    {
+        if (fData->parameterCount != sSharedMetadata.parameterCount)
+            return false;
+# if DISTRHO_PLUGIN_WANT_PROGRAMS
+        if (fData->programCount != sSharedMetadata.programCount)
+            return false;
+# endif
+# if DISTRHO_PLUGIN_WANT_STATE
+        if (fData->stateCount != sSharedMetadata.stateCount)
+            return false;
+# endif
+        return true;
+    }
+#endif
+
     DISTRHO_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PluginExporter)
     DISTRHO_PREVENT_HEAP_ALLOCATION
 };
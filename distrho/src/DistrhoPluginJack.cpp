@@ -23,10 +23,10 @@
 
 #if DISTRHO_PLUGIN_HAS_UI
 # include "DistrhoUIInternal.hpp"
-#else
-# include "../extra/Sleep.hpp"
 #endif
 
+#include "../extra/Sleep.hpp"
+
 #include "jack/jack.h"
 #include "jack/midiport.h"
 #include "jack/transport.h"
@@ -35,6 +35,31 @@
 # include <signal.h>
 #endif
 
+#ifndef DISTRHO_OS_WINDOWS
+# define DISTRHO_JACK_HAS_SESSION 1
+# include <ctime>
+# include <fcntl.h>
+# include <unistd.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+#else
+# define DISTRHO_JACK_HAS_SESSION 0
+#endif
+
+#if ! (DISTRHO_PLUGIN_HAS_UI || defined(DISTRHO_OS_WINDOWS))
+# define DISTRHO_JACK_HAS_CONTROL 1
+# include "../extra/RingBuffer.hpp"
+# include <cerrno>
+# include <poll.h>
+# include <unistd.h>
+# include <sys/socket.h>
+# include <sys/un.h>
+#else
+# define DISTRHO_JACK_HAS_CONTROL 0
+#endif
+
+#define DISTRHO_JACK_CAN_CHAIN (DISTRHO_PLUGIN_NUM_INPUTS > 0 && DISTRHO_PLUGIN_NUM_INPUTS == DISTRHO_PLUGIN_NUM_OUTPUTS)
+
 // -----------------------------------------------------------------------
 
 START_NAMESPACE_DISTRHO
@@ -42,6 +67,12 @@ START_NAMESPACE_DISTRHO
 #if DISTRHO_PLUGIN_HAS_UI && ! DISTRHO_PLUGIN_WANT_STATE
 static const setStateFunc setStateCallback = nullptr;
 #endif
+#if ! DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
+static const writeMidiFunc writeMidiCallback = nullptr;
+#endif
+#if ! DISTRHO_PLUGIN_WANT_TIMEPOS
+static const updateTimePosFunc updateTimePosCallback = nullptr;
+#endif
 
 // -----------------------------------------------------------------------
 
@@ -87,6 +118,196 @@ static void initSignalHandler()
 }
 #endif
 
+// -----------------------------------------------------------------------
+// Process helpers, shared by single and multi-instance modes
+
+#if DISTRHO_PLUGIN_WANT_TIMEPOS
+static void getJackTimePosition(jack_client_t* const client, TimePosition& timePosition)
+{
+    jack_position_t pos;
+    timePosition.playing = (jack_transport_query(client, &pos) == JackTransportRolling);
+
+    if (pos.unique_1 == pos.unique_2)
+    {
+        timePosition.frame = pos.frame;
+
+        if (pos.valid & JackTransportBBT)
+        {
+            timePosition.bbt.valid = true;
+
+            timePosition.bbt.bar  = pos.bar;
+            timePosition.bbt.beat = pos.beat;
+            timePosition.bbt.tick = pos.tick;
+            timePosition.bbt.barStartTick = pos.bar_start_tick;
+
+            timePosition.bbt.beatsPerBar = pos.beats_per_bar;
+            timePosition.bbt.beatType    = pos.beat_type;
+
+            timePosition.bbt.ticksPerBeat   = pos.ticks_per_beat;
+            timePosition.bbt.beatsPerMinute = pos.beats_per_minute;
+        }
+        else
+            timePosition.bbt.valid = false;
+    }
+    else
+    {
+        timePosition.bbt.valid = false;
+        timePosition.frame = 0;
+    }
+}
+#endif
+
+#if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+static uint32_t getJackMidiEvents(void* const midiBuf, MidiEvent* const midiEvents)
+{
+    uint32_t midiEventCount = 0;
+    bool needsSort = false;
+    jack_midi_event_t jevent;
+    MidiEvent tmpEvent;
+
+    for (uint32_t i=0, eventCount=jack_midi_get_event_count(midiBuf); i < eventCount; ++i)
+    {
+        if (jack_midi_event_get(&jevent, midiBuf, i) != 0)
+            break;
+        if (jevent.size == 0)
+            continue;
+
+        tmpEvent.frame = jevent.time;
+        tmpEvent.size  = jevent.size;
+
+        // SysEx and other long messages stay in the jack buffer, valid until the end of this cycle
+        if (tmpEvent.size > MidiEvent::kDataSize)
+        {
+            tmpEvent.dataExt = jevent.buffer;
+        }
+        else
+        {
+            std::memcpy(tmpEvent.data, jevent.buffer, tmpEvent.size);
+            tmpEvent.dataExt = nullptr;
+        }
+
+        if (midiEventCount < kMaxMidiEvents)
+        {
+            midiEvents[midiEventCount++] = tmpEvent;
+            continue;
+        }
+
+        // buffer full, drop new events but make room for note-offs so no notes are left hanging
+        if (! d_isMidiNoteOff(tmpEvent))
+            continue;
+
+        for (uint32_t j=kMaxMidiEvents; j-- > 0;)
+        {
+            if (d_isMidiNoteOff(midiEvents[j]))
+                continue;
+
+            midiEvents[j] = tmpEvent;
+            needsSort = true;
+            break;
+        }
+    }
+
+    if (needsSort)
+        d_sortMidiEvents(midiEvents, midiEventCount);
+
+    return midiEventCount;
+}
+#endif
+
+#if DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
+static bool writeJackMidiEvent(void* const midiBuf, const MidiEvent& midiEvent)
+{
+    DISTRHO_SAFE_ASSERT_RETURN(midiBuf != nullptr, false);
+
+    const uint8_t* const data = midiEvent.size > MidiEvent::kDataSize ? midiEvent.dataExt : midiEvent.data;
+    DISTRHO_SAFE_ASSERT_RETURN(data != nullptr, false);
+
+    return jack_midi_event_write(midiBuf, midiEvent.frame, data, midiEvent.size) == 0;
+}
+#endif
+
+// called from the JACK buffer size and sample rate callbacks.
+// plugins that can prepare a new configuration in advance keep processing,
+// the others are deactivated and re-activated as usual.
+// JACK does not process while these callbacks run, so a configuration still pending
+// from a previous call was never used and is simply replaced, without waiting for it.
+static void reconfigurePlugin(jack_client_t* const client, PluginExporter& plugin)
+{
+    const uint32_t bufferSize = jack_get_buffer_size(client);
+    const double   sampleRate = jack_get_sample_rate(client);
+
+    if (plugin.prepareConfiguration(bufferSize, sampleRate))
+        return;
+
+    plugin.setBufferSize(bufferSize, true);
+    plugin.setSampleRate(sampleRate, true);
+}
+
+#if DISTRHO_JACK_HAS_SESSION
+// -----------------------------------------------------------------------
+// Session file format
+//
+// header: 4 bytes magic, 4 bytes version, 4 bytes current program (0xffffffff if none),
+//         4 bytes parameter count, 4 bytes state count
+// each parameter: 4 bytes symbol length, symbol, NUL, 4 bytes IEEE-754 float value
+// each state: 4 bytes key length, key, NUL, 4 bytes value length, value, NUL
+//
+// Numbers are little-endian. Only input parameters are stored.
+// Parameters are matched by symbol and states by key when loading,
+// so a session survives plugin updates that add, remove or reorder them.
+
+static const char     kSessionMagic[4]   = { '\xff', 'D', 'P', 'S' };
+static const uint32_t kSessionVersion    = 1;
+static const uint32_t kSessionHeaderSize = 20;
+static const uint32_t kSessionNoProgram  = 0xffffffff;
+static const time_t   kSessionInterval   = 2; // seconds, changes in between are written together
+
+static inline
+char* writeSessionUInt32(char* const buf, const uint32_t value)
+{
+    buf[0] = static_cast<char>(value & 0xff);
+    buf[1] = static_cast<char>((value >> 8) & 0xff);
+    buf[2] = static_cast<char>((value >> 16) & 0xff);
+    buf[3] = static_cast<char>((value >> 24) & 0xff);
+    return buf + 4;
+}
+
+static inline
+char* writeSessionString(char* buf, const String& str)
+{
+    const std::size_t length(str.length());
+
+    buf = writeSessionUInt32(buf, static_cast<uint32_t>(length));
+    std::memcpy(buf, str.buffer(), length);
+    buf[length] = '\0';
+    return buf + length + 1;
+}
+
+static inline
+uint32_t readSessionUInt32(const char* const buf)
+{
+    const uint8_t* const ubuf = (const uint8_t*)buf;
+    return uint32_t(ubuf[0]) | (uint32_t(ubuf[1]) << 8) | (uint32_t(ubuf[2]) << 16) | (uint32_t(ubuf[3]) << 24);
+}
+
+static inline
+bool readSessionString(const char*& buf, const char* const end, const char*& str)
+{
+    if (end - buf < 4)
+        return false;
+
+    const uint32_t length(readSessionUInt32(buf));
+    buf += 4;
+
+    if (static_cast<std::size_t>(end - buf) <= length || buf[length] != '\0')
+        return false;
+
+    str  = buf;
+    buf += length + 1;
+    return true;
+}
+#endif
+
 // -----------------------------------------------------------------------
 
 #if DISTRHO_PLUGIN_HAS_UI
@@ -96,16 +317,27 @@ class PluginJack
 #endif
 {
 public:
-    PluginJack(jack_client_t* const client)
-        : fPlugin(),
+    PluginJack(jack_client_t* const client, const char* const controlPath = nullptr, const char* const sessionPath = nullptr)
+        : fPlugin(this, writeMidiCallback, updateTimePosCallback),
 #if DISTRHO_PLUGIN_HAS_UI
           fUI(this, 0, nullptr, setParameterValueCallback, setStateCallback, nullptr, setSizeCallback, fPlugin.getInstancePointer()),
+#endif
+#if DISTRHO_JACK_HAS_CONTROL
+          fParameterQueue(kControlQueueSize),
+#endif
+#if DISTRHO_JACK_HAS_SESSION
+          fSessionPath(sessionPath),
+          fSessionLastCheck(0),
 #endif
           fClient(client)
     {
         char strBuf[0xff+1];
         strBuf[0xff] = '\0';
 
+#if DISTRHO_PLUGIN_USE_UI_STREAM
+        fUI.setUIStream(fPlugin.getUIStream());
+#endif
+
 #if DISTRHO_PLUGIN_NUM_INPUTS > 0
         for (uint32_t i=0; i < DISTRHO_PLUGIN_NUM_INPUTS; ++i)
         {
@@ -122,20 +354,57 @@ public:
         }
 #endif
 
-#if DISTRHO_PLUGIN_IS_SYNTH
+#if DISTRHO_PLUGIN_WANT_MIDI_INPUT
         fPortMidiIn = jack_port_register(fClient, "midi-in", JACK_DEFAULT_MIDI_TYPE, JackPortIsInput, 0);
 #endif
+#if DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
+        fPortMidiOut = jack_port_register(fClient, "midi-out", JACK_DEFAULT_MIDI_TYPE, JackPortIsOutput, 0);
+        fPortMidiOutBuffer = nullptr;
+#endif
+
+#if DISTRHO_JACK_HAS_SESSION
+        std::memset(&fSessionData, 0, sizeof(fSessionData));
+        std::memset(&fSessionSaved, 0, sizeof(fSessionSaved));
+# if DISTRHO_PLUGIN_WANT_PROGRAMS
+        fCurrentProgram = kSessionNoProgram;
+# endif
+# if DISTRHO_PLUGIN_WANT_STATE
+        if (const uint32_t count = fPlugin.getStateCount())
+        {
+            fStateValues = new String[count];
+
+            for (uint32_t i=0; i < count; ++i)
+                fStateValues[i] = fPlugin.getStateDefaultValue(i);
+        }
+        else
+        {
+            fStateValues = nullptr;
+        }
+# endif
+#else
+        // unused
+        (void)sessionPath;
+#endif
 
 #if DISTRHO_PLUGIN_WANT_PROGRAMS
         if (fPlugin.getProgramCount() > 0)
         {
             fPlugin.loadProgram(0);
+# if DISTRHO_JACK_HAS_SESSION
+            fCurrentProgram = 0;
+# endif
 # if DISTRHO_PLUGIN_HAS_UI
             fUI.programLoaded(0);
 # endif
         }
 #endif
 
+#if DISTRHO_JACK_HAS_SESSION
+        // before activating and before the UI gets the initial parameter values
+        if (fSessionPath.isNotEmpty())
+            loadSession();
+#endif
+
         if (const uint32_t count = fPlugin.getParameterCount())
         {
             fLastOutputValues = new float[count];
@@ -169,6 +438,11 @@ public:
 
         jack_activate(fClient);
 
+#if ! DISTRHO_JACK_HAS_CONTROL
+        // unused
+        (void)controlPath;
+#endif
+
 #if DISTRHO_PLUGIN_HAS_UI
         if (const char* const name = jack_get_client_name(fClient))
             fUI.setWindowTitle(name);
@@ -177,13 +451,33 @@ public:
 
         fUI.exec(this);
 #else
+# if DISTRHO_JACK_HAS_CONTROL
+        if (controlPath != nullptr && runControl(controlPath))
+            return;
+# endif
+
         while (! gCloseSignalReceived)
+        {
+# if DISTRHO_JACK_HAS_SESSION
+            saveSessionIfNeeded(false);
+# endif
             d_sleep(1);
+        }
 #endif
     }
 
     ~PluginJack()
     {
+#if DISTRHO_JACK_HAS_SESSION
+        saveSessionIfNeeded(true);
+
+        delete[] fSessionData.data;
+        delete[] fSessionSaved.data;
+# if DISTRHO_PLUGIN_WANT_STATE
+        delete[] fStateValues;
+# endif
+#endif
+
         if (fClient != nullptr)
             jack_deactivate(fClient);
 
@@ -198,11 +492,16 @@ public:
         if (fClient == nullptr)
             return;
 
-#if DISTRHO_PLUGIN_IS_SYNTH
+#if DISTRHO_PLUGIN_WANT_MIDI_INPUT
         jack_port_unregister(fClient, fPortMidiIn);
         fPortMidiIn = nullptr;
 #endif
 
+#if DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
+        jack_port_unregister(fClient, fPortMidiOut);
+        fPortMidiOut = nullptr;
+#endif
+
 #if DISTRHO_PLUGIN_NUM_INPUTS > 0
         for (uint32_t i=0; i < DISTRHO_PLUGIN_NUM_INPUTS; ++i)
         {
@@ -247,18 +546,22 @@ protected:
             fUI.parameterChanged(i, value);
         }
 
+# if DISTRHO_JACK_HAS_SESSION
+        saveSessionIfNeeded(false);
+# endif
+
         fUI.exec_idle();
     }
 #endif
 
-    void jackBufferSize(const jack_nframes_t nframes)
+    void jackBufferSize(const jack_nframes_t)
     {
-        fPlugin.setBufferSize(nframes, true);
+        reconfigurePlugin(fClient, fPlugin);
     }
 
-    void jackSampleRate(const jack_nframes_t nframes)
+    void jackSampleRate(const jack_nframes_t)
     {
-        fPlugin.setSampleRate(nframes, true);
+        reconfigurePlugin(fClient, fPlugin);
     }
 
     void jackProcess(const jack_nframes_t nframes)
@@ -281,76 +584,43 @@ protected:
         static float** audioOuts = nullptr;
 #endif
 
-#if DISTRHO_PLUGIN_WANT_TIMEPOS
-        jack_position_t pos;
-        fTimePosition.playing = (jack_transport_query(fClient, &pos) == JackTransportRolling);
+#if DISTRHO_JACK_HAS_CONTROL
+        ParameterChange change;
 
-        if (pos.unique_1 == pos.unique_2)
+        while (fParameterQueue.get(change))
         {
-            fTimePosition.frame = pos.frame;
-
-            if (pos.valid & JackTransportBBT)
+# if DISTRHO_PLUGIN_WANT_PROGRAMS
+            if (change.index == kControlProgramChange)
             {
-                fTimePosition.bbt.valid = true;
-
-                fTimePosition.bbt.bar  = pos.bar;
-                fTimePosition.bbt.beat = pos.beat;
-                fTimePosition.bbt.tick = pos.tick;
-                fTimePosition.bbt.barStartTick = pos.bar_start_tick;
-
-                fTimePosition.bbt.beatsPerBar = pos.beats_per_bar;
-                fTimePosition.bbt.beatType    = pos.beat_type;
-
-                fTimePosition.bbt.ticksPerBeat   = pos.ticks_per_beat;
-                fTimePosition.bbt.beatsPerMinute = pos.beats_per_minute;
+                fPlugin.loadProgram(static_cast<uint32_t>(change.value));
+                continue;
             }
-            else
-                fTimePosition.bbt.valid = false;
-        }
-        else
-        {
-            fTimePosition.bbt.valid = false;
-            fTimePosition.frame = 0;
+# endif
+            fPlugin.setParameterValue(change.index, change.value);
         }
-
-        fPlugin.setTimePosition(fTimePosition);
 #endif
 
-#if DISTRHO_PLUGIN_IS_SYNTH
-        void* const midiBuf = jack_port_get_buffer(fPortMidiIn, nframes);
-
-        if (const uint32_t eventCount = jack_midi_get_event_count(midiBuf))
-        {
-            uint32_t  midiEventCount = 0;
-            MidiEvent midiEvents[eventCount];
-
-            jack_midi_event_t jevent;
-
-            for (uint32_t i=0; i < eventCount; ++i)
-            {
-                if (jack_midi_event_get(&jevent, midiBuf, i) != 0)
-                    break;
-
-                MidiEvent& midiEvent(midiEvents[midiEventCount++]);
+#if DISTRHO_PLUGIN_WANT_TIMEPOS
+        // queried later, only if the plugin asks for it
+        fPlugin.invalidateTimePosition();
+#endif
 
-                midiEvent.frame = jevent.time;
-                midiEvent.size  = jevent.size;
+#if DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
+        fPortMidiOutBuffer = jack_port_get_buffer(fPortMidiOut, nframes);
+        jack_midi_clear_buffer(fPortMidiOutBuffer);
+#endif
 
-                if (midiEvent.size > MidiEvent::kDataSize)
-                    midiEvent.dataExt = jevent.buffer;
-                else
-                    std::memcpy(midiEvent.data, jevent.buffer, midiEvent.size);
-            }
+#if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+        const uint32_t midiEventCount = getJackMidiEvents(jack_port_get_buffer(fPortMidiIn, nframes), fMidiEvents);
 
-            fPlugin.run(audioIns, audioOuts, nframes, midiEvents, midiEventCount);
-        }
-        else
-        {
-            fPlugin.run(audioIns, audioOuts, nframes, nullptr, 0);
-        }
+        fPlugin.run(audioIns, audioOuts, nframes, fMidiEvents, midiEventCount);
 #else
         fPlugin.run(audioIns, audioOuts, nframes);
 #endif
+
+#if DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
+        fPortMidiOutBuffer = nullptr;
+#endif
     }
 
     void jackShutdown()
@@ -369,10 +639,36 @@ protected:
         fPlugin.setParameterValue(index, value);
     }
 
+#if DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
+    bool writeMidi(const MidiEvent& midiEvent)
+    {
+        return writeJackMidiEvent(fPortMidiOutBuffer, midiEvent);
+    }
+#endif
+
+#if DISTRHO_PLUGIN_WANT_TIMEPOS
+    void updateTimePosition()
+    {
+        getJackTimePosition(fClient, fTimePosition);
+        fPlugin.setTimePosition(fTimePosition);
+    }
+#endif
+
 #if DISTRHO_PLUGIN_WANT_STATE
     void setState(const char* const key, const char* const value)
     {
         fPlugin.setState(key, value);
+
+# if DISTRHO_JACK_HAS_SESSION
+        for (uint32_t i=0, count=fPlugin.getStateCount(); i < count; ++i)
+        {
+            if (fPlugin.getStateKey(i) == key)
+            {
+                fStateValues[i] = value;
+                break;
+            }
+        }
+# endif
     }
 #endif
 
@@ -383,96 +679,1228 @@ protected:
     }
 #endif
 
+#if DISTRHO_JACK_HAS_SESSION
     // -------------------------------------------------------------------
+    // Session persistence, see the file format above.
+    // The current state is serialized every few seconds from the non-realtime thread,
+    // and only written when it differs from what was last saved.
+    // Writes go to a temporary file which is then renamed over the session file,
+    // so a crash or power loss never leaves a partially written session behind.
+
+    struct SessionBuffer {
+        char*       data;
+        std::size_t size;
+        std::size_t capacity;
+    };
+
+    void loadSession()
+    {
+        const int fd = ::open(fSessionPath, O_RDONLY);
 
-private:
-    PluginExporter fPlugin;
-#if DISTRHO_PLUGIN_HAS_UI
-    UIExporter     fUI;
-#endif
+        // no session yet, start from defaults
+        if (fd < 0)
+            return;
 
-    jack_client_t* fClient;
+        struct stat st;
 
-#if DISTRHO_PLUGIN_NUM_INPUTS > 0
-    jack_port_t* fPortAudioIns[DISTRHO_PLUGIN_NUM_INPUTS];
-#endif
-#if DISTRHO_PLUGIN_NUM_OUTPUTS > 0
-    jack_port_t* fPortAudioOuts[DISTRHO_PLUGIN_NUM_OUTPUTS];
-#endif
-#if DISTRHO_PLUGIN_IS_SYNTH
-    jack_port_t* fPortMidiIn;
-#endif
-#if DISTRHO_PLUGIN_WANT_TIMEPOS
-    TimePosition fTimePosition;
-#endif
+        if (::fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(kSessionHeaderSize))
+        {
+            ::close(fd);
+            d_stderr("Invalid session file '%s'", fSessionPath.buffer());
+            return;
+        }
 
-    // Temporary data
-    float* fLastOutputValues;
+        const std::size_t size = static_cast<std::size_t>(st.st_size);
+        void* const map = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
 
-    // -------------------------------------------------------------------
-    // Callbacks
+        DISTRHO_SAFE_ASSERT_RETURN(map != MAP_FAILED,);
 
-    #define uiPtr ((PluginJack*)ptr)
+        if (applySession((const char*)map, size))
+        {
+            // keep a copy of what is on disk, so an unchanged session is not written again
+            reserveSessionBuffer(fSessionSaved, size);
+            std::memcpy(fSessionSaved.data, map, size);
+            fSessionSaved.size = size;
+        }
+        else
+        {
+            d_stderr("Invalid session file '%s'", fSessionPath.buffer());
+        }
 
-    static int jackBufferSizeCallback(jack_nframes_t nframes, void* ptr)
-    {
-        uiPtr->jackBufferSize(nframes);
-        return 0;
+        ::munmap(map, size);
     }
 
-    static int jackSampleRateCallback(jack_nframes_t nframes, void* ptr)
+    bool applySession(const char* const data, const std::size_t size)
     {
-        uiPtr->jackSampleRate(nframes);
-        return 0;
-    }
+        if (std::memcmp(data, kSessionMagic, 4) != 0 || readSessionUInt32(data + 4) != kSessionVersion)
+            return false;
 
-    static int jackProcessCallback(jack_nframes_t nframes, void* ptr)
-    {
-        uiPtr->jackProcess(nframes);
-        return 0;
-    }
+        const char* buf = data + kSessionHeaderSize;
+        const char* const end = data + size;
 
-    static void jackShutdownCallback(void* ptr)
-    {
-        uiPtr->jackShutdown();
-    }
+# if DISTRHO_PLUGIN_WANT_PROGRAMS
+        // programs first, they would overwrite the parameter values otherwise
+        const uint32_t program = readSessionUInt32(data + 8);
 
-    static void setParameterValueCallback(void* ptr, uint32_t index, float value)
-    {
-        uiPtr->setParameterValue(index, value);
-    }
+        if (program < fPlugin.getProgramCount())
+        {
+            fPlugin.loadProgram(program);
+            fCurrentProgram = program;
+#  if DISTRHO_PLUGIN_HAS_UI
+            fUI.programLoaded(program);
+#  endif
+        }
+# endif
 
-#if DISTRHO_PLUGIN_WANT_STATE
-    static void setStateCallback(void* ptr, const char* key, const char* value)
-    {
-        uiPtr->setState(key, value);
-    }
-#endif
+        const uint32_t parameterCount = fPlugin.getParameterCount();
+        const char* symbol;
+        float value;
 
-#if DISTRHO_PLUGIN_HAS_UI
-    static void setSizeCallback(void* ptr, uint width, uint height)
-    {
-        uiPtr->setSize(width, height);
-    }
-#endif
+        for (uint32_t i=0, count=readSessionUInt32(data + 12); i < count; ++i)
+        {
+            if (! readSessionString(buf, end, symbol) || end - buf < 4)
+                return false;
 
-    #undef uiPtr
-};
+            const uint32_t bits = readSessionUInt32(buf);
+            std::memcpy(&value, &bits, sizeof(float));
+            buf += 4;
 
-END_NAMESPACE_DISTRHO
+            for (uint32_t j=0; j < parameterCount; ++j)
+            {
+                if (fPlugin.isParameterOutput(j) || fPlugin.getParameterSymbol(j) != symbol)
+                    continue;
 
-// -----------------------------------------------------------------------
+                fPlugin.setParameterValue(j, fPlugin.getParameterRanges(j).getFixedValue(value));
+                break;
+            }
+        }
 
-int main()
-{
-    USE_NAMESPACE_DISTRHO;
+        const char* key;
+        const char* stateValue;
 
-    jack_status_t  status = jack_status_t(0x0);
-    jack_client_t* client = jack_client_open(DISTRHO_PLUGIN_NAME, JackNoStartServer, &status);
+        for (uint32_t i=0, count=readSessionUInt32(data + 16); i < count; ++i)
+        {
+            if (! readSessionString(buf, end, key) || ! readSessionString(buf, end, stateValue))
+                return false;
+
+# if DISTRHO_PLUGIN_WANT_STATE
+            setState(key, stateValue);
+#  if DISTRHO_PLUGIN_HAS_UI
+            fUI.stateChanged(key, stateValue);
+#  endif
+# endif
+        }
 
-    if (client == nullptr)
-    {
-        String errorString;
+        return true;
+    }
+
+    static void reserveSessionBuffer(SessionBuffer& buffer, const std::size_t size)
+    {
+        if (size <= buffer.capacity)
+            return;
+
+        delete[] buffer.data;
+        buffer.data     = new char[size];
+        buffer.capacity = size;
+    }
+
+    void buildSession()
+    {
+        const uint32_t parameterCount = fPlugin.getParameterCount();
+        uint32_t inputCount = 0;
+
+        std::size_t size = kSessionHeaderSize;
+
+        for (uint32_t i=0; i < parameterCount; ++i)
+        {
+            if (fPlugin.isParameterOutput(i))
+                continue;
+
+            size += 4 + fPlugin.getParameterSymbol(i).length() + 1 + 4;
+            ++inputCount;
+        }
+
+# if DISTRHO_PLUGIN_WANT_STATE
+        const uint32_t stateCount = fPlugin.getStateCount();
+
+        for (uint32_t i=0; i < stateCount; ++i)
+        {
+#  if DISTRHO_PLUGIN_WANT_FULL_STATE
+            fStateValues[i] = fPlugin.getState(fPlugin.getStateKey(i));
+#  endif
+            size += 4 + fPlugin.getStateKey(i).length() + 1 + 4 + fStateValues[i].length() + 1;
+        }
+# else
+        const uint32_t stateCount = 0;
+# endif
+
+# if DISTRHO_PLUGIN_WANT_PROGRAMS
+        const uint32_t program = fCurrentProgram;
+# else
+        const uint32_t program = kSessionNoProgram;
+# endif
+
+        reserveSessionBuffer(fSessionData, size);
+
+        char* buf = fSessionData.data;
+
+        std::memcpy(buf, kSessionMagic, 4);
+        buf = writeSessionUInt32(buf + 4, kSessionVersion);
+        buf = writeSessionUInt32(buf, program);
+        buf = writeSessionUInt32(buf, inputCount);
+        buf = writeSessionUInt32(buf, stateCount);
+
+        for (uint32_t i=0; i < parameterCount; ++i)
+        {
+            if (fPlugin.isParameterOutput(i))
+                continue;
+
+            const float value = fPlugin.getParameterValue(i);
+            uint32_t bits;
+            std::memcpy(&bits, &value, sizeof(float));
+
+            buf = writeSessionString(buf, fPlugin.getParameterSymbol(i));
+            buf = writeSessionUInt32(buf, bits);
+        }
+
+# if DISTRHO_PLUGIN_WANT_STATE
+        for (uint32_t i=0; i < stateCount; ++i)
+        {
+            buf = writeSessionString(buf, fPlugin.getStateKey(i));
+            buf = writeSessionString(buf, fStateValues[i]);
+        }
+# endif
+
+        DISTRHO_SAFE_ASSERT(buf == fSessionData.data + size);
+        fSessionData.size = size;
+    }
+
+    bool writeSessionFile(const char* data, std::size_t size)
+    {
+        const String tmpPath(fSessionPath + ".tmp");
+        const int fd = ::open(tmpPath, O_WRONLY|O_CREAT|O_TRUNC, 0644);
+
+        if (fd < 0)
+        {
+            d_stderr("Failed to write session file '%s'", tmpPath.buffer());
+            return false;
+        }
+
+        bool ok = true;
+
+        for (ssize_t w; size != 0; data += w, size -= static_cast<std::size_t>(w))
+        {
+            if ((w = ::write(fd, data, size)) <= 0)
+            {
+                ok = false;
+                break;
+            }
+        }
+
+        // make sure the data is on disk before the rename makes it visible
+        if (::fsync(fd) != 0)
+            ok = false;
+
+        ::close(fd);
+
+        if (ok && ::rename(tmpPath, fSessionPath) == 0)
+            return true;
+
+        d_stderr("Failed to write session file '%s'", fSessionPath.buffer());
+        ::unlink(tmpPath);
+        return false;
+    }
+
+    void saveSessionIfNeeded(const bool ignoreInterval)
+    {
+        if (fSessionPath.isEmpty())
+            return;
+
+        const time_t now = std::time(nullptr);
+
+        if (! ignoreInterval && now - fSessionLastCheck < kSessionInterval)
+            return;
+
+        fSessionLastCheck = now;
+
+        buildSession();
+
+        if (fSessionData.size == fSessionSaved.size && std::memcmp(fSessionData.data, fSessionSaved.data, fSessionData.size) == 0)
+            return;
+
+        if (! writeSessionFile(fSessionData.data, fSessionData.size))
+            return;
+
+        const SessionBuffer saved(fSessionSaved);
+        fSessionSaved = fSessionData;
+        fSessionData  = saved;
+    }
+#endif
+
+#if DISTRHO_JACK_HAS_CONTROL
+    // -------------------------------------------------------------------
+    // Headless control over a local socket, one text command per line:
+    //   set <parameter> <value> [<parameter> <value> ...]
+    //   get [<parameter> ...]
+    //   list
+    //   program <index>
+    //   state <key> <value>
+    // Parameters are given by index or symbol.
+    // Every command is answered with a single line starting with "ok" or "error".
+    // Client sockets are non-blocking, replies are queued per client and clients that
+    // stop reading them are disconnected, so they cannot stall the others.
+
+    static const uint32_t kControlQueueSize   = 1024;
+    static const uint32_t kControlLineSize    = 4096;
+    static const uint32_t kControlOutputSize  = 65536;
+    static const uint32_t kMaxControlClients  = 16;
+    static const uint32_t kMaxControlChanges  = kControlLineSize / 4; // "set" pairs need at least 4 chars
+
+    // queued changes with this index load the program given by their value,
+    // so that program loads stay in order with the parameter changes around them
+    static const uint32_t kControlProgramChange = 0xffffffff;
+
+    struct ParameterChange {
+        uint32_t index;
+        float    value;
+    };
+
+    struct ControlClient {
+        int      fd;
+        uint32_t size;
+        uint32_t outputSize;
+        char     buffer[kControlLineSize];
+        char     output[kControlOutputSize];
+    };
+
+    bool runControl(const char* const path)
+    {
+        const int server = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        DISTRHO_SAFE_ASSERT_RETURN(server >= 0, false);
+
+        sockaddr_un addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        std::strncpy(addr.sun_path, path, sizeof(addr.sun_path)-1);
+
+        ::unlink(path);
+
+        if (::bind(server, (sockaddr*)&addr, sizeof(addr)) != 0 || ::listen(server, kMaxControlClients) != 0)
+        {
+            d_stderr("Failed to create control socket '%s'", path);
+            ::close(server);
+            return false;
+        }
+
+        // clients going away must not terminate the process
+        ::signal(SIGPIPE, SIG_IGN);
+
+        ControlClient* const clients = new ControlClient[kMaxControlClients];
+        uint32_t clientCount = 0;
+        pollfd fds[kMaxControlClients+1];
+
+        while (! gCloseSignalReceived)
+        {
+            saveSessionIfNeeded(false);
+
+            fds[0].fd      = server;
+            fds[0].events  = POLLIN;
+            fds[0].revents = 0;
+
+            for (uint32_t i=0; i < clientCount; ++i)
+            {
+                fds[i+1].fd      = clients[i].fd;
+                fds[i+1].events  = clients[i].outputSize != 0 ? POLLIN|POLLOUT : POLLIN;
+                fds[i+1].revents = 0;
+            }
+
+            if (::poll(fds, clientCount+1, 200) <= 0)
+                continue;
+
+            // backwards, so that removing a client does not shift the ones still to check
+            for (uint32_t i=clientCount; i-- > 0;)
+            {
+                if (fds[i+1].revents == 0 || serviceControlClient(clients[i], fds[i+1].revents))
+                    continue;
+
+                ::close(clients[i].fd);
+
+                if (i != --clientCount)
+                    std::memcpy(&clients[i], &clients[clientCount], sizeof(ControlClient));
+            }
+
+            if (fds[0].revents & POLLIN)
+            {
+                const int fd = ::accept(server, nullptr, nullptr);
+
+                if (fd < 0)
+                    continue;
+
+                if (clientCount == kMaxControlClients || ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK) != 0)
+                {
+                    ::close(fd);
+                    continue;
+                }
+
+                clients[clientCount].fd         = fd;
+                clients[clientCount].size       = 0;
+                clients[clientCount].outputSize = 0;
+                ++clientCount;
+            }
+        }
+
+        for (uint32_t i=0; i < clientCount; ++i)
+            ::close(clients[i].fd);
+
+        delete[] clients;
+
+        ::close(server);
+        ::unlink(path);
+        return true;
+    }
+
+    // returns false if the client has to be disconnected
+    bool serviceControlClient(ControlClient& client, const short revents)
+    {
+        if ((revents & POLLOUT) != 0 && ! flushControlClient(client))
+            return false;
+
+        if ((revents & (POLLIN|POLLHUP|POLLERR)) != 0 && ! readControlClient(client))
+            return false;
+
+        return flushControlClient(client);
+    }
+
+    bool readControlClient(ControlClient& client)
+    {
+        const ssize_t r = ::read(client.fd, client.buffer + client.size, kControlLineSize - client.size);
+
+        if (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+            return true;
+        if (r <= 0)
+            return false;
+
+        client.size += static_cast<uint32_t>(r);
+
+        char* start = client.buffer;
+        char* const end = client.buffer + client.size;
+
+        for (char* nl; (nl = (char*)std::memchr(start, '\n', end - start)) != nullptr; start = nl + 1)
+        {
+            *nl = '\0';
+
+            if (nl != start && nl[-1] == '\r')
+                nl[-1] = '\0';
+
+            String reply(handleControlCommand(start));
+            reply += "\n";
+
+            if (! queueControlReply(client, reply.buffer(), reply.length()))
+                return false;
+        }
+
+        client.size = static_cast<uint32_t>(end - start);
+
+        if (client.size == kControlLineSize)
+        {
+            client.size = 0;
+            return queueControlReply(client, "error line too long\n", 20);
+        }
+
+        std::memmove(client.buffer, start, client.size);
+        return true;
+    }
+
+    static bool queueControlReply(ControlClient& client, const char* const data, const std::size_t size)
+    {
+        if (size > kControlOutputSize - client.outputSize)
+        {
+            d_stderr("Control client is not reading its replies, disconnecting");
+            return false;
+        }
+
+        std::memcpy(client.output + client.outputSize, data, size);
+        client.outputSize += static_cast<uint32_t>(size);
+        return true;
+    }
+
+    // writes as much of the queued replies as the socket takes without blocking
+    static bool flushControlClient(ControlClient& client)
+    {
+        uint32_t written = 0;
+
+        while (written < client.outputSize)
+        {
+            const ssize_t w = ::write(client.fd, client.output + written, client.outputSize - written);
+
+            if (w < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                break;
+            if (w < 0 && errno == EINTR)
+                continue;
+            if (w <= 0)
+                return false;
+
+            written += static_cast<uint32_t>(w);
+        }
+
+        client.outputSize -= written;
+        std::memmove(client.output, client.output + written, client.outputSize);
+        return true;
+    }
+
+    static char* nextControlToken(char*& cursor) noexcept
+    {
+        while (*cursor == ' ' || *cursor == '\t')
+            ++cursor;
+
+        if (*cursor == '\0')
+            return nullptr;
+
+        char* const token = cursor;
+
+        while (*cursor != '\0' && *cursor != ' ' && *cursor != '\t')
+            ++cursor;
+
+        if (*cursor != '\0')
+            *cursor++ = '\0';
+
+        return token;
+    }
+
+    bool findControlParameter(const char* const token, uint32_t& index) const
+    {
+        const uint32_t count = fPlugin.getParameterCount();
+
+        char* end;
+        const ulong value = std::strtoul(token, &end, 10);
+
+        if (end != token && *end == '\0')
+        {
+            index = static_cast<uint32_t>(value);
+            return value < count;
+        }
+
+        for (uint32_t i=0; i < count; ++i)
+        {
+            if (fPlugin.getParameterSymbol(i) == token)
+            {
+                index = i;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    String handleControlCommand(char* cursor)
+    {
+        const char* const command = nextControlToken(cursor);
+
+        if (command == nullptr)
+            return String("error empty command");
+
+        char strBuf[0xff+1];
+        strBuf[0xff] = '\0';
+
+        if (std::strcmp(command, "set") == 0)
+        {
+            // all pairs are validated before any is applied
+            ParameterChange changes[kMaxControlChanges];
+            uint32_t count = 0;
+
+            for (const char* token; (token = nextControlToken(cursor)) != nullptr; ++count)
+            {
+                if (count == kMaxControlChanges)
+                    return String("error too many parameters");
+
+                const char* const valueToken = nextControlToken(cursor);
+                ParameterChange& change(changes[count]);
+                char* end;
+
+                if (! findControlParameter(token, change.index))
+                    return String("error unknown parameter ") + token;
+                if (fPlugin.isParameterOutput(change.index))
+                    return String("error output parameter ") + token;
+                if (valueToken == nullptr)
+                    return String("error missing value for ") + token;
+
+                change.value = std::strtof(valueToken, &end);
+
+                if (end == valueToken || *end != '\0')
+                    return String("error invalid value ") + valueToken;
+
+                change.value = fPlugin.getParameterRanges(change.index).getFixedValue(change.value);
+            }
+
+            if (count == 0)
+                return String("error missing parameter");
+            if (fParameterQueue.getWriteSpace() < count)
+                return String("error queue full");
+
+            fParameterQueue.write(changes, count);
+            return String("ok");
+        }
+
+        if (std::strcmp(command, "get") == 0)
+        {
+            String reply("ok");
+            const char* token = nextControlToken(cursor);
+
+            if (token == nullptr)
+            {
+                for (uint32_t i=0, count=fPlugin.getParameterCount(); i < count; ++i)
+                {
+                    std::snprintf(strBuf, 0xff, " %g", static_cast<double>(fPlugin.getParameterValue(i)));
+                    reply += strBuf;
+                }
+                return reply;
+            }
+
+            for (uint32_t index; token != nullptr; token = nextControlToken(cursor))
+            {
+                if (! findControlParameter(token, index))
+                    return String("error unknown parameter ") + token;
+
+                std::snprintf(strBuf, 0xff, " %g", static_cast<double>(fPlugin.getParameterValue(index)));
+                reply += strBuf;
+            }
+
+            return reply;
+        }
+
+        if (std::strcmp(command, "list") == 0)
+        {
+            String reply("ok");
+
+            for (uint32_t i=0, count=fPlugin.getParameterCount(); i < count; ++i)
+            {
+                reply += " ";
+                reply += fPlugin.getParameterSymbol(i);
+            }
+
+            return reply;
+        }
+
+        if (std::strcmp(command, "program") == 0)
+        {
+# if DISTRHO_PLUGIN_WANT_PROGRAMS
+            const char* const token = nextControlToken(cursor);
+
+            if (token == nullptr)
+                return String("error missing program");
+
+            char* end;
+            const ulong index = std::strtoul(token, &end, 10);
+
+            if (end == token || *end != '\0' || index >= fPlugin.getProgramCount())
+                return String("error invalid program ") + token;
+
+            const ParameterChange change = { kControlProgramChange, static_cast<float>(index) };
+
+            if (! fParameterQueue.put(change))
+                return String("error queue full");
+
+            fCurrentProgram = static_cast<uint32_t>(index);
+            return String("ok");
+# else
+            return String("error programs not supported");
+# endif
+        }
+
+        if (std::strcmp(command, "state") == 0)
+        {
+# if DISTRHO_PLUGIN_WANT_STATE
+            const char* const key = nextControlToken(cursor);
+
+            if (key == nullptr)
+                return String("error missing state key");
+
+            // the value is the rest of the line, spaces included
+            while (*cursor == ' ' || *cursor == '\t')
+                ++cursor;
+
+            setState(key, cursor);
+            return String("ok");
+# else
+            return String("error state not supported");
+# endif
+        }
+
+        return String("error unknown command ") + command;
+    }
+#endif
+
+    // -------------------------------------------------------------------
+
+private:
+    PluginExporter fPlugin;
+#if DISTRHO_PLUGIN_HAS_UI
+    UIExporter     fUI;
+#endif
+#if DISTRHO_JACK_HAS_CONTROL
+    RingBuffer<ParameterChange> fParameterQueue;
+#endif
+#if DISTRHO_JACK_HAS_SESSION
+    String        fSessionPath;
+    time_t        fSessionLastCheck;
+    SessionBuffer fSessionData;  // scratch, rebuilt on every check
+    SessionBuffer fSessionSaved; // contents of the session file
+# if DISTRHO_PLUGIN_WANT_PROGRAMS
+    uint32_t      fCurrentProgram;
+# endif
+# if DISTRHO_PLUGIN_WANT_STATE
+    String*       fStateValues;
+# endif
+#endif
+
+    jack_client_t* fClient;
+
+#if DISTRHO_PLUGIN_NUM_INPUTS > 0
+    jack_port_t* fPortAudioIns[DISTRHO_PLUGIN_NUM_INPUTS];
+#endif
+#if DISTRHO_PLUGIN_NUM_OUTPUTS > 0
+    jack_port_t* fPortAudioOuts[DISTRHO_PLUGIN_NUM_OUTPUTS];
+#endif
+#if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+    jack_port_t* fPortMidiIn;
+#endif
+#if DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
+    jack_port_t* fPortMidiOut;
+    void*        fPortMidiOutBuffer;
+#endif
+#if DISTRHO_PLUGIN_WANT_TIMEPOS
+    TimePosition fTimePosition;
+#endif
+
+    // Temporary data
+    float* fLastOutputValues;
+#if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+    MidiEvent fMidiEvents[kMaxMidiEvents];
+#endif
+
+    // -------------------------------------------------------------------
+    // Callbacks
+
+    #define uiPtr ((PluginJack*)ptr)
+
+    static int jackBufferSizeCallback(jack_nframes_t nframes, void* ptr)
+    {
+        uiPtr->jackBufferSize(nframes);
+        return 0;
+    }
+
+    static int jackSampleRateCallback(jack_nframes_t nframes, void* ptr)
+    {
+        uiPtr->jackSampleRate(nframes);
+        return 0;
+    }
+
+    static int jackProcessCallback(jack_nframes_t nframes, void* ptr)
+    {
+        uiPtr->jackProcess(nframes);
+        return 0;
+    }
+
+    static void jackShutdownCallback(void* ptr)
+    {
+        uiPtr->jackShutdown();
+    }
+
+    static void setParameterValueCallback(void* ptr, uint32_t index, float value)
+    {
+        uiPtr->setParameterValue(index, value);
+    }
+
+#if DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
+    static bool writeMidiCallback(void* ptr, const MidiEvent& midiEvent)
+    {
+        return uiPtr->writeMidi(midiEvent);
+    }
+#endif
+
+#if DISTRHO_PLUGIN_WANT_TIMEPOS
+    static void updateTimePosCallback(void* ptr)
+    {
+        uiPtr->updateTimePosition();
+    }
+#endif
+
+#if DISTRHO_PLUGIN_WANT_STATE
+    static void setStateCallback(void* ptr, const char* key, const char* value)
+    {
+        uiPtr->setState(key, value);
+    }
+#endif
+
+#if DISTRHO_PLUGIN_HAS_UI
+    static void setSizeCallback(void* ptr, uint width, uint height)
+    {
+        uiPtr->setSize(width, height);
+    }
+#endif
+
+    #undef uiPtr
+};
+
+// -----------------------------------------------------------------------
+// Several plugin instances inside a single jack client, without UI.
+// Instances either run side by side, each with its own set of ports,
+// or as a chain where the audio outputs of one instance feed the inputs of the next.
+// In a chain only the last instance writes to the MIDI output, like it is the only one
+// writing to the audio outputs, since JACK needs the events of a port in time order.
+
+class PluginJackMulti
+{
+public:
+    PluginJackMulti(jack_client_t* const client, const uint32_t instanceCount, const bool chain)
+        : fClient(client),
+          fInstanceCount(instanceCount),
+          fInstances(new Instance[instanceCount]),
+          fPortSetCount(chain ? 1 : instanceCount),
+          fPortSets(new PortSet[fPortSetCount]),
+          fChain(chain)
+    {
+        char strBuf[0xff+1];
+        strBuf[0xff] = '\0';
+
+        for (uint32_t k=0; k < fPortSetCount; ++k)
+        {
+            PortSet& ports(fPortSets[k]);
+
+#if DISTRHO_PLUGIN_NUM_INPUTS > 0
+            for (uint32_t i=0; i < DISTRHO_PLUGIN_NUM_INPUTS; ++i)
+            {
+                if (fChain)
+                    std::snprintf(strBuf, 0xff, "in%i", i+1);
+                else
+                    std::snprintf(strBuf, 0xff, "%u-in%i", k+1, i+1);
+                ports.audioIns[i] = jack_port_register(fClient, strBuf, JACK_DEFAULT_AUDIO_TYPE, JackPortIsInput, 0);
+            }
+#endif
+
+#if DISTRHO_PLUGIN_NUM_OUTPUTS > 0
+            for (uint32_t i=0; i < DISTRHO_PLUGIN_NUM_OUTPUTS; ++i)
+            {
+                if (fChain)
+                    std::snprintf(strBuf, 0xff, "out%i", i+1);
+                else
+                    std::snprintf(strBuf, 0xff, "%u-out%i", k+1, i+1);
+                ports.audioOuts[i] = jack_port_register(fClient, strBuf, JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
+            }
+#endif
+
+#if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+            if (fChain)
+                std::strcpy(strBuf, "midi-in");
+            else
+                std::snprintf(strBuf, 0xff, "%u-midi-in", k+1);
+            ports.midiIn = jack_port_register(fClient, strBuf, JACK_DEFAULT_MIDI_TYPE, JackPortIsInput, 0);
+#endif
+
+#if DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
+            if (fChain)
+                std::strcpy(strBuf, "midi-out");
+            else
+                std::snprintf(strBuf, 0xff, "%u-midi-out", k+1);
+            ports.midiOut = jack_port_register(fClient, strBuf, JACK_DEFAULT_MIDI_TYPE, JackPortIsOutput, 0);
+#endif
+        }
+
+#if DISTRHO_JACK_CAN_CHAIN
+        for (uint32_t i=0; i < DISTRHO_PLUGIN_NUM_OUTPUTS; ++i)
+            fChainBuffers[0][i] = fChainBuffers[1][i] = nullptr;
+
+        if (fChain)
+            allocateChainBuffers(jack_get_buffer_size(fClient));
+#endif
+
+        for (uint32_t k=0; k < fInstanceCount; ++k)
+        {
+#if DISTRHO_PLUGIN_WANT_PROGRAMS
+            if (fInstances[k].plugin.getProgramCount() > 0)
+                fInstances[k].plugin.loadProgram(0);
+#endif
+            fInstances[k].plugin.activate();
+        }
+
+        jack_set_buffer_size_callback(fClient, jackBufferSizeCallback, this);
+        jack_set_sample_rate_callback(fClient, jackSampleRateCallback, this);
+        jack_set_process_callback(fClient, jackProcessCallback, this);
+        jack_on_shutdown(fClient, jackShutdownCallback, this);
+
+        jack_activate(fClient);
+
+        while (! gCloseSignalReceived && fClient != nullptr)
+            d_sleep(1);
+    }
+
+    ~PluginJackMulti()
+    {
+        if (fClient != nullptr)
+            jack_deactivate(fClient);
+
+        for (uint32_t k=0; k < fInstanceCount; ++k)
+            fInstances[k].plugin.deactivate();
+
+        if (fClient != nullptr)
+        {
+            for (uint32_t k=0; k < fPortSetCount; ++k)
+            {
+                PortSet& ports(fPortSets[k]);
+
+#if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+                jack_port_unregister(fClient, ports.midiIn);
+#endif
+#if DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
+                jack_port_unregister(fClient, ports.midiOut);
+#endif
+#if DISTRHO_PLUGIN_NUM_INPUTS > 0
+                for (uint32_t i=0; i < DISTRHO_PLUGIN_NUM_INPUTS; ++i)
+                    jack_port_unregister(fClient, ports.audioIns[i]);
+#endif
+#if DISTRHO_PLUGIN_NUM_OUTPUTS > 0
+                for (uint32_t i=0; i < DISTRHO_PLUGIN_NUM_OUTPUTS; ++i)
+                    jack_port_unregister(fClient, ports.audioOuts[i]);
+#endif
+            }
+
+            jack_client_close(fClient);
+        }
+
+#if DISTRHO_JACK_CAN_CHAIN
+        freeChainBuffers();
+#endif
+
+        delete[] fPortSets;
+        delete[] fInstances;
+    }
+
+    // -------------------------------------------------------------------
+
+protected:
+    void jackBufferSize(const jack_nframes_t nframes)
+    {
+#if DISTRHO_JACK_CAN_CHAIN
+        if (fChain)
+            allocateChainBuffers(nframes);
+#else
+        // unused
+        (void)nframes;
+#endif
+
+        for (uint32_t k=0; k < fInstanceCount; ++k)
+            reconfigurePlugin(fClient, fInstances[k].plugin);
+    }
+
+    void jackSampleRate(const jack_nframes_t)
+    {
+        for (uint32_t k=0; k < fInstanceCount; ++k)
+            reconfigurePlugin(fClient, fInstances[k].plugin);
+    }
+
+    void jackProcess(const jack_nframes_t nframes)
+    {
+#if DISTRHO_PLUGIN_WANT_TIMEPOS
+        getJackTimePosition(fClient, fTimePosition);
+#endif
+
+#if DISTRHO_PLUGIN_NUM_INPUTS > 0
+        const float* audioIns[DISTRHO_PLUGIN_NUM_INPUTS];
+#else
+        static const float** audioIns = nullptr;
+#endif
+#if DISTRHO_PLUGIN_NUM_OUTPUTS > 0
+        float* audioOuts[DISTRHO_PLUGIN_NUM_OUTPUTS];
+#else
+        static float** audioOuts = nullptr;
+#endif
+#if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+        uint32_t midiEventCount = 0;
+#endif
+#if DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
+        void* midiOutBuffer = nullptr;
+#endif
+
+        // instances are processed serially, in the order they were created
+        for (uint32_t k=0; k < fInstanceCount; ++k)
+        {
+            Instance& instance(fInstances[k]);
+            const PortSet& ports(fPortSets[fChain ? 0 : k]);
+            const bool firstInChain = !fChain || k == 0;
+
+#if DISTRHO_PLUGIN_NUM_INPUTS > 0
+            for (uint32_t i=0; i < DISTRHO_PLUGIN_NUM_INPUTS; ++i)
+            {
+# if DISTRHO_JACK_CAN_CHAIN
+                if (! firstInChain)
+                    audioIns[i] = audioOuts[i];
+                else
+# endif
+                audioIns[i] = (const float*)jack_port_get_buffer(ports.audioIns[i], nframes);
+            }
+#endif
+
+#if DISTRHO_PLUGIN_NUM_OUTPUTS > 0
+            for (uint32_t i=0; i < DISTRHO_PLUGIN_NUM_OUTPUTS; ++i)
+            {
+# if DISTRHO_JACK_CAN_CHAIN
+                if (fChain && k+1 != fInstanceCount)
+                    audioOuts[i] = fChainBuffers[k & 1][i];
+                else
+# endif
+                audioOuts[i] = (float*)jack_port_get_buffer(ports.audioOuts[i], nframes);
+            }
+#endif
+
+#if DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
+            if (firstInChain)
+            {
+                midiOutBuffer = jack_port_get_buffer(ports.midiOut, nframes);
+                jack_midi_clear_buffer(midiOutBuffer);
+            }
+            instance.midiOutBuffer = (! fChain || k+1 == fInstanceCount) ? midiOutBuffer : nullptr;
+#endif
+
+#if DISTRHO_PLUGIN_WANT_TIMEPOS
+            instance.plugin.setTimePosition(fTimePosition);
+#endif
+
+#if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+            // in chain mode all instances receive the same events
+            if (firstInChain)
+                midiEventCount = getJackMidiEvents(jack_port_get_buffer(ports.midiIn, nframes), fMidiEvents);
+
+            instance.plugin.run(audioIns, audioOuts, nframes, fMidiEvents, midiEventCount);
+#else
+            instance.plugin.run(audioIns, audioOuts, nframes);
+#endif
+
+#if DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
+            instance.midiOutBuffer = nullptr;
+#endif
+        }
+    }
+
+    void jackShutdown()
+    {
+        d_stderr("jack has shutdown, quitting now...");
+        fClient = nullptr;
+    }
+
+    // -------------------------------------------------------------------
+
+private:
+    struct Instance {
+        PluginExporter plugin;
+#if DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
+        void* midiOutBuffer;
+
+        Instance()
+            : plugin(this, writeMidiCallback),
+              midiOutBuffer(nullptr) {}
+
+        static bool writeMidiCallback(void* ptr, const MidiEvent& midiEvent)
+        {
+            Instance* const instance = (Instance*)ptr;
+
+            // not the last instance of a chain
+            if (instance->midiOutBuffer == nullptr)
+                return false;
+
+            return writeJackMidiEvent(instance->midiOutBuffer, midiEvent);
+        }
+#endif
+    };
+
+    struct PortSet {
+#if DISTRHO_PLUGIN_NUM_INPUTS > 0
+        jack_port_t* audioIns[DISTRHO_PLUGIN_NUM_INPUTS];
+#endif
+#if DISTRHO_PLUGIN_NUM_OUTPUTS > 0
+        jack_port_t* audioOuts[DISTRHO_PLUGIN_NUM_OUTPUTS];
+#endif
+#if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+        jack_port_t* midiIn;
+#endif
+#if DISTRHO_PLUGIN_WANT_MIDI_OUTPUT
+        jack_port_t* midiOut;
+#endif
+    };
+
+    jack_client_t* fClient;
+
+    const uint32_t  fInstanceCount;
+    Instance* const fInstances;
+
+    const uint32_t fPortSetCount;
+    PortSet* const fPortSets;
+
+    const bool fChain;
+
+#if DISTRHO_JACK_CAN_CHAIN
+    // intermediate audio between chained instances, alternating between 2 sets
+    float* fChainBuffers[2][DISTRHO_PLUGIN_NUM_OUTPUTS];
+
+    void allocateChainBuffers(const uint32_t bufferSize)
+    {
+        freeChainBuffers();
+
+        for (uint32_t i=0; i < DISTRHO_PLUGIN_NUM_OUTPUTS; ++i)
+        {
+            fChainBuffers[0][i] = new float[bufferSize];
+            fChainBuffers[1][i] = new float[bufferSize];
+        }
+    }
+
+    void freeChainBuffers()
+    {
+        for (uint32_t i=0; i < DISTRHO_PLUGIN_NUM_OUTPUTS; ++i)
+        {
+            delete[] fChainBuffers[0][i];
+            delete[] fChainBuffers[1][i];
+            fChainBuffers[0][i] = fChainBuffers[1][i] = nullptr;
+        }
+    }
+#endif
+
+#if DISTRHO_PLUGIN_WANT_TIMEPOS
+    TimePosition fTimePosition;
+#endif
+#if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+    MidiEvent fMidiEvents[kMaxMidiEvents];
+#endif
+
+    // -------------------------------------------------------------------
+    // Callbacks
+
+    #define thisPtr ((PluginJackMulti*)ptr)
+
+    static int jackBufferSizeCallback(jack_nframes_t nframes, void* ptr)
+    {
+        thisPtr->jackBufferSize(nframes);
+        return 0;
+    }
+
+    static int jackSampleRateCallback(jack_nframes_t nframes, void* ptr)
+    {
+        thisPtr->jackSampleRate(nframes);
+        return 0;
+    }
+
+    static int jackProcessCallback(jack_nframes_t nframes, void* ptr)
+    {
+        thisPtr->jackProcess(nframes);
+        return 0;
+    }
+
+    static void jackShutdownCallback(void* ptr)
+    {
+        thisPtr->jackShutdown();
+    }
+
+    #undef thisPtr
+
+    DISTRHO_DECLARE_NON_COPY_CLASS(PluginJackMulti)
+};
+
+END_NAMESPACE_DISTRHO
+
+// -----------------------------------------------------------------------
+
+int main(int argc, char* argv[])
+{
+    USE_NAMESPACE_DISTRHO;
+
+    uint32_t instanceCount = 1;
+    bool chain = false;
+    bool unknownArgs = false;
+#if DISTRHO_JACK_HAS_CONTROL
+    const char* controlPath = nullptr;
+#endif
+#if DISTRHO_JACK_HAS_SESSION
+    const char* sessionPath = nullptr;
+#endif
+
+    for (int i=1; i < argc; ++i)
+    {
+        if ((std::strcmp(argv[i], "-n") == 0 || std::strcmp(argv[i], "--instances") == 0) && i+1 < argc)
+        {
+            const int count = std::atoi(argv[++i]);
+
+            if (count < 1)
+            {
+                d_stderr("Invalid instance count '%s'", argv[i]);
+                return 1;
+            }
+
+            instanceCount = static_cast<uint32_t>(count);
+        }
+        else if (std::strcmp(argv[i], "--chain") == 0)
+        {
+            chain = true;
+        }
+#if DISTRHO_JACK_HAS_CONTROL
+        else if (std::strcmp(argv[i], "--control") == 0 && i+1 < argc)
+        {
+            controlPath = argv[++i];
+        }
+#endif
+#if DISTRHO_JACK_HAS_SESSION
+        else if (std::strcmp(argv[i], "--session") == 0 && i+1 < argc)
+        {
+            sessionPath = argv[++i];
+        }
+#endif
+        else
+        {
+            // launchers and session managers can pass their own arguments (e.g. -psn_* on macOS)
+            d_stderr("Ignoring unknown argument '%s'", argv[i]);
+            unknownArgs = true;
+        }
+    }
+
+    if (unknownArgs)
+    {
+#if DISTRHO_JACK_HAS_CONTROL
+        d_stderr("Usage: %s [-n|--instances <count>] [--chain] [--control <socket-path>] [--session <file>]", argv[0]);
+#elif DISTRHO_JACK_HAS_SESSION
+        d_stderr("Usage: %s [-n|--instances <count>] [--chain] [--session <file>]", argv[0]);
+#else
+        d_stderr("Usage: %s [-n|--instances <count>] [--chain]", argv[0]);
+#endif
+    }
+
+#if DISTRHO_JACK_HAS_CONTROL
+    if (controlPath != nullptr && (instanceCount > 1 || chain))
+    {
+        d_stderr("The control socket is only available for a single plugin instance");
+        return 1;
+    }
+#endif
+
+#if DISTRHO_JACK_HAS_SESSION
+    if (sessionPath != nullptr && (instanceCount > 1 || chain))
+    {
+        d_stderr("Session files are only available for a single plugin instance");
+        return 1;
+    }
+#endif
+
+#if ! DISTRHO_JACK_CAN_CHAIN
+    if (chain)
+    {
+        d_stderr("Cannot chain instances of this plugin, it needs the same number of audio inputs and outputs");
+        return 1;
+    }
+#endif
+
+    jack_status_t  status = jack_status_t(0x0);
+    jack_client_t* client = jack_client_open(DISTRHO_PLUGIN_NAME, JackNoStartServer, &status);
+
+    if (client == nullptr)
+    {
+        String errorString;
 
         if (status & JackFailure)
             errorString += "Overall operation failed;\n";
@@ -522,7 +1950,30 @@ int main()
     d_lastUiSampleRate = d_lastSampleRate;
 #endif
 
+    // check the plugin can be used before creating any instance that would run
+    {
+        const PluginExporter plugin;
+
+        if (! plugin.isValid())
+        {
+            jack_client_close(client);
+            return 1;
+        }
+    }
+
+    if (instanceCount > 1 || chain)
+    {
+        const PluginJackMulti p(client, instanceCount, chain);
+        return 0;
+    }
+
+#if DISTRHO_JACK_HAS_CONTROL
+    const PluginJack p(client, controlPath, sessionPath);
+#elif DISTRHO_JACK_HAS_SESSION
+    const PluginJack p(client, nullptr, sessionPath);
+#else
     const PluginJack p(client);
+#endif
 
     return 0;
 }
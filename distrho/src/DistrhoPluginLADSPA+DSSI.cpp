@@ -38,6 +38,64 @@
 
 START_NAMESPACE_DISTRHO
 
+#if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+// -----------------------------------------------------------------------
+// ALSA sequencer to MIDI translation, indexed by event type
+
+enum SeqEventKind {
+    kSeqEventIgnored = 0,
+    kSeqEventNote,      // note and velocity
+    kSeqEventControl,   // controller and value
+    kSeqEventValue,     // value only
+    kSeqEventPitchBend, // signed 14-bit value
+    kSeqEventControl14, // 14-bit controller, split into MSB and LSB
+    kSeqEventParameter  // 14-bit NRPN or RPN, expanded into 4 controller messages
+};
+
+struct SeqEventMapping {
+    uint8_t kind;
+    uint8_t status;
+    uint8_t size;
+    uint8_t count;      // maximum number of MIDI messages produced
+    uint8_t controller; // parameter number MSB controller, for kSeqEventParameter
+};
+
+static const SeqEventMapping kSeqEventMappings[] = {
+    /*  0 SYSTEM      */ { kSeqEventIgnored,   0x00, 0, 0, 0 },
+    /*  1 RESULT      */ { kSeqEventIgnored,   0x00, 0, 0, 0 },
+    /*  2             */ { kSeqEventIgnored,   0x00, 0, 0, 0 },
+    /*  3             */ { kSeqEventIgnored,   0x00, 0, 0, 0 },
+    /*  4             */ { kSeqEventIgnored,   0x00, 0, 0, 0 },
+    /*  5 NOTE        */ { kSeqEventIgnored,   0x00, 0, 0, 0 },
+    /*  6 NOTEON      */ { kSeqEventNote,      0x90, 3, 1, 0 },
+    /*  7 NOTEOFF     */ { kSeqEventNote,      0x80, 3, 1, 0 },
+    /*  8 KEYPRESS    */ { kSeqEventNote,      0xA0, 3, 1, 0 },
+    /*  9             */ { kSeqEventIgnored,   0x00, 0, 0, 0 },
+    /* 10 CONTROLLER  */ { kSeqEventControl,   0xB0, 3, 1, 0 },
+    /* 11 PGMCHANGE   */ { kSeqEventValue,     0xC0, 2, 1, 0 },
+    /* 12 CHANPRESS   */ { kSeqEventValue,     0xD0, 2, 1, 0 },
+    /* 13 PITCHBEND   */ { kSeqEventPitchBend, 0xE0, 3, 1, 0 },
+    /* 14 CONTROL14   */ { kSeqEventControl14, 0xB0, 3, 2, 0 },
+    /* 15 NONREGPARAM */ { kSeqEventParameter, 0xB0, 3, 4, 99 },
+    /* 16 REGPARAM    */ { kSeqEventParameter, 0xB0, 3, 4, 101 }
+};
+
+static const uint kSeqEventMappingCount = sizeof(kSeqEventMappings)/sizeof(kSeqEventMappings[0]);
+
+static inline
+void setMidiEvent(MidiEvent& midiEvent, const uint32_t frame, const uint32_t size,
+                  const uint8_t status, const uint data1, const uint data2) noexcept
+{
+    midiEvent.frame   = frame;
+    midiEvent.size    = size;
+    midiEvent.data[0] = status;
+    midiEvent.data[1] = data1 & 0x7F;
+    midiEvent.data[2] = size > 2 ? data2 & 0x7F : 0;
+    midiEvent.data[3] = 0;
+    midiEvent.dataExt = nullptr;
+}
+#endif
+
 // -----------------------------------------------------------------------
 
 class PluginLadspaDssi
@@ -100,6 +158,11 @@ public:
 
     // -------------------------------------------------------------------
 
+    bool isValid() const noexcept
+    {
+        return fPlugin.isValid();
+    }
+
     void ladspa_activate()
     {
         fPlugin.activate();
@@ -192,79 +255,108 @@ public:
 
 #if DISTRHO_PLUGIN_WANT_MIDI_INPUT
         // Get MIDI Events
-        uint32_t  midiEventCount = 0;
-        MidiEvent midiEvents[eventCount];
+        uint32_t midiEventCount = 0;
 
-        for (uint32_t i=0, j; i < eventCount; ++i)
+        for (uint32_t i=0; i < eventCount; ++i)
         {
             const snd_seq_event_t& seqEvent(events[i]);
+            const uint32_t frame = seqEvent.time.tick;
+
+            if (seqEvent.type == SND_SEQ_EVENT_SYSEX)
+            {
+                const uint8_t* const data = (const uint8_t*)seqEvent.data.ext.ptr;
+                const uint32_t       size = seqEvent.data.ext.len;
+
+                if (data == nullptr || size == 0)
+                    continue;
+                if (midiEventCount >= kMaxMidiEvents)
+                    break;
+
+                MidiEvent& midiEvent(fMidiEvents[midiEventCount++]);
+                midiEvent.frame = frame;
+                midiEvent.size  = size;
+
+                // the host keeps the data alive until the end of this run call
+                if (size > MidiEvent::kDataSize)
+                {
+                    midiEvent.dataExt = data;
+                }
+                else
+                {
+                    std::memset(midiEvent.data, 0, MidiEvent::kDataSize);
+                    std::memcpy(midiEvent.data, data, size);
+                    midiEvent.dataExt = nullptr;
+                }
+                continue;
+            }
 
-            // FIXME
-            if (seqEvent.data.note.channel > 0xF || seqEvent.data.control.channel > 0xF)
+            if (seqEvent.type >= kSeqEventMappingCount)
                 continue;
 
-            switch (seqEvent.type)
+            const SeqEventMapping& mapping(kSeqEventMappings[seqEvent.type]);
+
+            if (mapping.kind == kSeqEventIgnored)
+                continue;
+            if (midiEventCount + mapping.count > kMaxMidiEvents)
+                break;
+
+            // note and control events share the same channel field
+            const uint8_t channel = seqEvent.data.control.channel;
+
+            if (channel > 0xF)
+                continue;
+
+            const uint8_t status = mapping.status | channel;
+            const uint    param  = seqEvent.data.control.param;
+            const int     value  = seqEvent.data.control.value;
+            MidiEvent* const midiEvent = fMidiEvents + midiEventCount;
+
+            switch (mapping.kind)
             {
-            case SND_SEQ_EVENT_NOTEOFF:
-                j = midiEventCount++;
-                midiEvents[j].frame   = seqEvent.time.tick;
-                midiEvents[j].size    = 3;
-                midiEvents[j].data[0] = 0x80 + seqEvent.data.note.channel;
-                midiEvents[j].data[1] = seqEvent.data.note.note;
-                midiEvents[j].data[2] = 0;
-                midiEvents[j].data[3] = 0;
+            case kSeqEventNote:
+                setMidiEvent(midiEvent[0], frame, mapping.size, status, seqEvent.data.note.note, seqEvent.data.note.velocity);
+                midiEventCount += 1;
                 break;
-            case SND_SEQ_EVENT_NOTEON:
-                j = midiEventCount++;
-                midiEvents[j].frame   = seqEvent.time.tick;
-                midiEvents[j].size    = 3;
-                midiEvents[j].data[0] = 0x90 + seqEvent.data.note.channel;
-                midiEvents[j].data[1] = seqEvent.data.note.note;
-                midiEvents[j].data[2] = seqEvent.data.note.velocity;
-                midiEvents[j].data[3] = 0;
+            case kSeqEventControl:
+                setMidiEvent(midiEvent[0], frame, mapping.size, status, param, value);
+                midiEventCount += 1;
                 break;
-            case SND_SEQ_EVENT_KEYPRESS:
-                j = midiEventCount++;
-                midiEvents[j].frame   = seqEvent.time.tick;
-                midiEvents[j].size    = 3;
-                midiEvents[j].data[0] = 0xA0 + seqEvent.data.note.channel;
-                midiEvents[j].data[1] = seqEvent.data.note.note;
-                midiEvents[j].data[2] = seqEvent.data.note.velocity;
-                midiEvents[j].data[3] = 0;
+            case kSeqEventValue:
+                setMidiEvent(midiEvent[0], frame, mapping.size, status, value, 0);
+                midiEventCount += 1;
                 break;
-            case SND_SEQ_EVENT_CONTROLLER:
-                j = midiEventCount++;
-                midiEvents[j].frame   = seqEvent.time.tick;
-                midiEvents[j].size    = 3;
-                midiEvents[j].data[0] = 0xB0 + seqEvent.data.control.channel;
-                midiEvents[j].data[1] = seqEvent.data.control.param;
-                midiEvents[j].data[2] = seqEvent.data.control.value;
-                midiEvents[j].data[3] = 0;
+            case kSeqEventPitchBend: {
+                const int bend = value < -8192 ? 0 : value > 8191 ? 16383 : value + 8192;
+                setMidiEvent(midiEvent[0], frame, mapping.size, status, bend, bend >> 7);
+                midiEventCount += 1;
                 break;
-            case SND_SEQ_EVENT_CHANPRESS:
-                j = midiEventCount++;
-                midiEvents[j].frame   = seqEvent.time.tick;
-                midiEvents[j].size    = 2;
-                midiEvents[j].data[0] = 0xD0 + seqEvent.data.control.channel;
-                midiEvents[j].data[1] = seqEvent.data.control.value;
-                midiEvents[j].data[2] = 0;
-                midiEvents[j].data[3] = 0;
+            }
+            case kSeqEventControl14:
+                // only controllers 0-31 have a matching LSB controller
+                if (param < 32)
+                {
+                    setMidiEvent(midiEvent[0], frame, mapping.size, status, param,      value >> 7);
+                    setMidiEvent(midiEvent[1], frame, mapping.size, status, param + 32, value);
+                    midiEventCount += 2;
+                }
+                else
+                {
+                    setMidiEvent(midiEvent[0], frame, mapping.size, status, param, value);
+                    midiEventCount += 1;
+                }
                 break;
-#if 0 // TODO
-            case SND_SEQ_EVENT_PITCHBEND:
-                j = midiEventCount++;
-                midiEvents[j].frame   = seqEvent.time.tick;
-                midiEvents[j].size    = 3;
-                midiEvents[j].data[0] = 0xE0 + seqEvent.data.control.channel;
-                midiEvents[j].data[1] = 0;
-                midiEvents[j].data[2] = 0;
-                midiEvents[j].data[3] = 0;
+            case kSeqEventParameter:
+                // parameter number MSB and LSB, then data entry MSB and LSB
+                setMidiEvent(midiEvent[0], frame, mapping.size, status, mapping.controller,     param >> 7);
+                setMidiEvent(midiEvent[1], frame, mapping.size, status, mapping.controller - 1, param);
+                setMidiEvent(midiEvent[2], frame, mapping.size, status, 6,                      value >> 7);
+                setMidiEvent(midiEvent[3], frame, mapping.size, status, 38,                     value);
+                midiEventCount += 4;
                 break;
-#endif
             }
         }
 
-        fPlugin.run(fPortAudioIns, fPortAudioOuts, sampleCount, midiEvents, midiEventCount);
+        fPlugin.run(fPortAudioIns, fPortAudioOuts, sampleCount, fMidiEvents, midiEventCount);
 #else
         fPlugin.run(fPortAudioIns, fPortAudioOuts, sampleCount);
 #endif
@@ -354,6 +446,9 @@ private:
 
     // Temporary data
     LADSPA_Data* fLastControlValues;
+#if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+    MidiEvent    fMidiEvents[kMaxMidiEvents];
+#endif
 
     // -------------------------------------------------------------------
 
@@ -385,7 +480,15 @@ static LADSPA_Handle ladspa_instantiate(const LADSPA_Descriptor*, ulong sampleRa
         d_lastBufferSize = 2048;
     d_lastSampleRate = sampleRate;
 
-    return new PluginLadspaDssi();
+    PluginLadspaDssi* const instance = new PluginLadspaDssi();
+
+    if (! instance->isValid())
+    {
+        delete instance;
+        return nullptr;
+    }
+
+    return instance;
 }
 
 #define instancePtr ((PluginLadspaDssi*)instance)
@@ -496,6 +599,8 @@ static DSSI_Descriptor sDssiDescriptor = {
     /* run_synth                    */ nullptr,
 # endif
     /* run_synth_adding             */ nullptr,
+    // instances share no DSP state that could be processed in one pass, and providing
+    // run_multiple_synths would force hosts to pass every active instance in every call
     /* run_multiple_synths          */ nullptr,
     /* run_multiple_synths_adding   */ nullptr,
     nullptr, nullptr
@@ -516,6 +621,10 @@ public:
         d_lastBufferSize = 0;
         d_lastSampleRate = 0.0;
 
+        // leave the descriptors empty, so none is returned to the host
+        if (! plugin.isValid())
+            return;
+
         // Get port count, init
         ulong port = 0;
         ulong portCount = DISTRHO_PLUGIN_NUM_INPUTS + DISTRHO_PLUGIN_NUM_OUTPUTS + plugin.getParameterCount();
@@ -696,7 +805,7 @@ DISTRHO_PLUGIN_EXPORT
 const LADSPA_Descriptor* ladspa_descriptor(ulong index)
 {
     USE_NAMESPACE_DISTRHO
-    return (index == 0) ? &sLadspaDescriptor : nullptr;
+    return (index == 0 && sLadspaDescriptor.Label != nullptr) ? &sLadspaDescriptor : nullptr;
 }
 
 #ifdef DISTRHO_PLUGIN_TARGET_DSSI
@@ -704,7 +813,7 @@ DISTRHO_PLUGIN_EXPORT
 const DSSI_Descriptor* dssi_descriptor(ulong index)
 {
     USE_NAMESPACE_DISTRHO
-    return (index == 0) ? &sDssiDescriptor : nullptr;
+    return (index == 0 && sLadspaDescriptor.Label != nullptr) ? &sDssiDescriptor : nullptr;
 }
 #endif
 
@@ -44,8 +44,9 @@
 # define DISTRHO_PLUGIN_LV2_STATE_PREFIX "urn:distrho:"
 #endif
 
+#define DISTRHO_LV2_USE_UI_STREAM  (DISTRHO_PLUGIN_WANT_UI_STREAM && DISTRHO_PLUGIN_HAS_UI && ! DISTRHO_PLUGIN_WANT_DIRECT_ACCESS)
 #define DISTRHO_LV2_USE_EVENTS_IN  (DISTRHO_PLUGIN_WANT_MIDI_INPUT || DISTRHO_PLUGIN_WANT_TIMEPOS || (DISTRHO_PLUGIN_WANT_STATE && DISTRHO_PLUGIN_HAS_UI))
-#define DISTRHO_LV2_USE_EVENTS_OUT (DISTRHO_PLUGIN_WANT_MIDI_OUTPUT || (DISTRHO_PLUGIN_WANT_STATE && DISTRHO_PLUGIN_HAS_UI))
+#define DISTRHO_LV2_USE_EVENTS_OUT (DISTRHO_PLUGIN_WANT_MIDI_OUTPUT || (DISTRHO_PLUGIN_WANT_STATE && DISTRHO_PLUGIN_HAS_UI) || DISTRHO_LV2_USE_UI_STREAM)
 
 START_NAMESPACE_DISTRHO
 
@@ -110,6 +111,7 @@ public:
         if (const uint32_t count = fPlugin.getStateCount())
         {
             fNeededUiSends = new bool[count];
+            fStateURIDs    = new LV2_URID[count];
 
             for (uint32_t i=0; i < count; ++i)
             {
@@ -117,11 +119,16 @@ public:
 
                 const String& dkey(fPlugin.getStateKey(i));
                 fStateMap[dkey] = fPlugin.getStateDefaultValue(i);
+
+                // mapped once here, save and restore reuse them
+                const String urnKey(DISTRHO_PLUGIN_LV2_STATE_PREFIX + dkey);
+                fStateURIDs[i] = fUridMap->map(fUridMap->handle, urnKey.buffer());
             }
         }
         else
         {
             fNeededUiSends = nullptr;
+            fStateURIDs    = nullptr;
         }
 #else
         // unused
@@ -150,12 +157,23 @@ public:
             fNeededUiSends = nullptr;
         }
 
+        if (fStateURIDs != nullptr)
+        {
+            delete[] fStateURIDs;
+            fStateURIDs = nullptr;
+        }
+
         fStateMap.clear();
 #endif
     }
 
     // -------------------------------------------------------------------
 
+    bool isValid() const noexcept
+    {
+        return fPlugin.isValid();
+    }
+
     void lv2_activate()
     {
 #if DISTRHO_PLUGIN_WANT_TIMEPOS
@@ -465,7 +483,7 @@ public:
                                            fLastPositionData.beatUnit > 0 &&
                                            fLastPositionData.beatsPerBar > 0.0f);
 
-                fPlugin.setTimePosition(fTimePosition);
+                updatePluginTimePosition();
 
                 continue;
             }
@@ -527,21 +545,28 @@ public:
 
 #if DISTRHO_PLUGIN_WANT_TIMEPOS
             // update timePos for next callback
-            if (d_isNotZero(fLastPositionData.speed))
+            if (fLastPositionData.speed > 0.0)
             {
-                if (fLastPositionData.speed > 0.0)
-                {
-                    // playing forwards
-                    fLastPositionData.frame += sampleCount;
-                }
-                else
-                {
-                    // playing backwards
-                    fLastPositionData.frame -= sampleCount;
+                // playing forwards
+                fTimeExtrapolator.advance(sampleCount, fSampleRate);
+                fTimePosition = fTimeExtrapolator.getPosition();
 
-                    if (fLastPositionData.frame < 0)
-                        fLastPositionData.frame = 0;
-                }
+                fLastPositionData.frame = fTimePosition.frame;
+
+                if (fLastPositionData.barBeat >= 0.0f)
+                    fLastPositionData.barBeat = fTimeExtrapolator.getBarBeat();
+                if (fLastPositionData.bar >= 0)
+                    fLastPositionData.bar = fTimePosition.bbt.bar - 1;
+
+                fPlugin.setTimePosition(fTimeExtrapolator);
+            }
+            else if (d_isNotZero(fLastPositionData.speed))
+            {
+                // playing backwards
+                fLastPositionData.frame -= sampleCount;
+
+                if (fLastPositionData.frame < 0)
+                    fLastPositionData.frame = 0;
 
                 fTimePosition.frame = fLastPositionData.frame;
 
@@ -579,21 +604,30 @@ public:
                     fTimePosition.bbt.beatsPerMinute = std::abs(beatsPerMinute);
                 }
 
-                fPlugin.setTimePosition(fTimePosition);
+                updatePluginTimePosition();
             }
 #endif
         }
 
         updateParameterOutputs();
 
-#if DISTRHO_PLUGIN_WANT_STATE && DISTRHO_PLUGIN_HAS_UI
+#if DISTRHO_LV2_USE_EVENTS_OUT
+# if (DISTRHO_PLUGIN_WANT_STATE && DISTRHO_PLUGIN_HAS_UI) || DISTRHO_LV2_USE_UI_STREAM
         const uint32_t capacity = fPortEventsOut->atom.size;
+        uint32_t offset = 0;
+# endif
 
-        bool needsInit = true;
-        uint32_t size, offset = 0;
-        LV2_Atom_Event* aev;
+        fPortEventsOut->atom.size = 0;
+        fPortEventsOut->atom.type = fURIDs.atomSequence;
+        fPortEventsOut->body.unit = 0;
+        fPortEventsOut->body.pad  = 0;
 
         // TODO - MIDI Output
+#endif
+
+#if DISTRHO_PLUGIN_WANT_STATE && DISTRHO_PLUGIN_HAS_UI
+        uint32_t size;
+        LV2_Atom_Event* aev;
 
         for (uint32_t i=0, count=fPlugin.getStateCount(); i < count; ++i)
         {
@@ -617,15 +651,6 @@ public:
                 if (sizeof(LV2_Atom_Event) + msgSize > capacity - offset)
                     break;
 
-                if (needsInit)
-                {
-                    fPortEventsOut->atom.size = 0;
-                    fPortEventsOut->atom.type = fURIDs.atomSequence;
-                    fPortEventsOut->body.unit = 0;
-                    fPortEventsOut->body.pad  = 0;
-                    needsInit = false;
-                }
-
                 // reserve msg space
                 char msgBuf[msgSize];
                 std::memset(msgBuf, 0, msgSize);
@@ -650,6 +675,35 @@ public:
             }
         }
 #endif
+
+#if DISTRHO_LV2_USE_UI_STREAM
+        // send stream data to UI, as much as the output buffer allows.
+        // capacity includes the sequence body, events are written after it.
+        if (capacity > sizeof(LV2_Atom_Sequence_Body) + offset + sizeof(LV2_Atom_Event))
+        {
+            RingBuffer<float>* const uiStream(fPlugin.getUIStream());
+
+            const uint32_t space = capacity - sizeof(LV2_Atom_Sequence_Body) - offset;
+
+            // round the payload down so that the padded event still fits
+            const uint32_t maxCount = ((space - sizeof(LV2_Atom_Event)) & ~7U) / sizeof(float);
+            const uint32_t readSpace = uiStream->getReadSpace();
+
+            if (const uint32_t count = readSpace < maxCount ? readSpace : maxCount)
+            {
+                const uint32_t eventSize = lv2_atom_pad_size(sizeof(LV2_Atom_Event) + count * sizeof(float));
+                DISTRHO_SAFE_ASSERT_RETURN(eventSize <= space,);
+
+                LV2_Atom_Event* const streamEvent = (LV2_Atom_Event*)(LV2_ATOM_CONTENTS(LV2_Atom_Sequence, fPortEventsOut) + offset);
+                streamEvent->time.frames = 0;
+                streamEvent->body.type   = fURIDs.distrhoUIStream;
+                streamEvent->body.size   = count * sizeof(float);
+                uiStream->read((float*)LV2_ATOM_BODY(&streamEvent->body), count);
+
+                fPortEventsOut->atom.size += eventSize;
+            }
+        }
+#endif
     }
 
     // -------------------------------------------------------------------
@@ -760,24 +814,26 @@ public:
 #if DISTRHO_PLUGIN_WANT_STATE
     LV2_State_Status lv2_save(const LV2_State_Store_Function store, const LV2_State_Handle handle)
     {
-# if DISTRHO_PLUGIN_WANT_FULL_STATE
-        // Update current state
-        for (StringMap::const_iterator cit=fStateMap.begin(), cite=fStateMap.end(); cit != cite; ++cit)
+        for (uint32_t i=0, count=fPlugin.getStateCount(); i < count; ++i)
         {
-            const String& key = cit->first;
-            fStateMap[key] = fPlugin.getState(key);
-        }
-# endif
+            const String& key(fPlugin.getStateKey(i));
 
-        for (StringMap::const_iterator cit=fStateMap.begin(), cite=fStateMap.end(); cit != cite; ++cit)
-        {
-            const String& key   = cit->first;
-            const String& value = cit->second;
+            for (StringMap::iterator it=fStateMap.begin(), ite=fStateMap.end(); it != ite; ++it)
+            {
+                if (it->first != key)
+                    continue;
 
-            const String urnKey(DISTRHO_PLUGIN_LV2_STATE_PREFIX + key);
+# if DISTRHO_PLUGIN_WANT_FULL_STATE
+                // Update current state
+                it->second = fPlugin.getState(key);
+# endif
+
+                const String& value(it->second);
 
-            // some hosts need +1 for the null terminator, even though the type is string
-            store(handle, fUridMap->map(fUridMap->handle, urnKey.buffer()), value.buffer(), value.length()+1, fURIDs.atomString, LV2_STATE_IS_POD|LV2_STATE_IS_PORTABLE);
+                // some hosts need +1 for the null terminator, even though the type is string
+                store(handle, fStateURIDs[i], value.buffer(), value.length()+1, fURIDs.atomString, LV2_STATE_IS_POD|LV2_STATE_IS_PORTABLE);
+                break;
+            }
         }
 
         return LV2_STATE_SUCCESS;
@@ -791,12 +847,11 @@ public:
         for (uint32_t i=0, count=fPlugin.getStateCount(); i < count; ++i)
         {
             const String& key(fPlugin.getStateKey(i));
-            const String urnKey(DISTRHO_PLUGIN_LV2_STATE_PREFIX + key);
 
             size  = 0;
             type  = 0;
             flags = LV2_STATE_IS_POD|LV2_STATE_IS_PORTABLE;
-            const void* data = retrieve(handle, fUridMap->map(fUridMap->handle, urnKey.buffer()), &size, &type, &flags);
+            const void* data = retrieve(handle, fStateURIDs[i], &size, &type, &flags);
 
             if (data == nullptr || size == 0)
                 continue;
@@ -838,6 +893,13 @@ public:
     {
         return fPlugin.getInstancePointer();
     }
+
+# if DISTRHO_PLUGIN_USE_UI_STREAM
+    void* lv2_get_ui_stream()
+    {
+        return fPlugin.getUIStream();
+    }
+# endif
 #endif
 
     // -------------------------------------------------------------------
@@ -876,6 +938,7 @@ private:
 #endif
 #if DISTRHO_PLUGIN_WANT_TIMEPOS
     TimePosition fTimePosition;
+    TimePositionExtrapolator fTimeExtrapolator;
 
     struct Lv2PositionData {
         int64_t  bar;
@@ -911,6 +974,7 @@ private:
         LV2_URID atomSequence;
         LV2_URID atomString;
         LV2_URID distrhoState;
+        LV2_URID distrhoUIStream;
         LV2_URID midiEvent;
         LV2_URID timePosition;
         LV2_URID timeBar;
@@ -932,6 +996,7 @@ private:
               atomSequence(uridMap->map(uridMap->handle, LV2_ATOM__Sequence)),
               atomString(uridMap->map(uridMap->handle, LV2_ATOM__String)),
               distrhoState(uridMap->map(uridMap->handle, DISTRHO_PLUGIN_LV2_STATE_PREFIX "KeyValueState")),
+              distrhoUIStream(uridMap->map(uridMap->handle, DISTRHO_PLUGIN_LV2_STATE_PREFIX "UIStream")),
               midiEvent(uridMap->map(uridMap->handle, LV2_MIDI__MidiEvent)),
               timePosition(uridMap->map(uridMap->handle, LV2_TIME__Position)),
               timeBar(uridMap->map(uridMap->handle, LV2_TIME__bar)),
@@ -951,6 +1016,7 @@ private:
 #if DISTRHO_PLUGIN_WANT_STATE
     StringMap fStateMap;
     bool* fNeededUiSends;
+    LV2_URID* fStateURIDs;
 
     void setState(const char* const key, const char* const newValue)
     {
@@ -994,6 +1060,20 @@ private:
             *fPortLatency = fPlugin.getLatency();
 #endif
     }
+
+#if DISTRHO_PLUGIN_WANT_TIMEPOS
+    void updatePluginTimePosition()
+    {
+        // keep the exact beat position, BBT ticks lose precision
+        if (fLastPositionData.barBeat >= 0.0f)
+            fTimeExtrapolator.setPosition(fTimePosition, fLastPositionData.barBeat,
+                                          fLastPositionData.beatsPerMinute * fLastPositionData.speed);
+        else
+            fTimeExtrapolator.setPosition(fTimePosition);
+
+        fPlugin.setTimePosition(fTimeExtrapolator);
+    }
+#endif
 };
 
 // -----------------------------------------------------------------------
@@ -1072,7 +1152,15 @@ static LV2_Handle lv2_instantiate(const LV2_Descriptor*, double sampleRate, cons
 
     d_lastSampleRate = sampleRate;
 
-    return new PluginLv2(sampleRate, uridMap, worker, usingNominal);
+    PluginLv2* const instance = new PluginLv2(sampleRate, uridMap, worker, usingNominal);
+
+    if (! instance->isValid())
+    {
+        delete instance;
+        return nullptr;
+    }
+
+    return instance;
 }
 
 #define instancePtr ((PluginLv2*)instance)
@@ -1154,6 +1242,13 @@ static void* lv2_get_instance_pointer(LV2_Handle instance)
 {
     return instancePtr->lv2_get_instance_pointer();
 }
+
+# if DISTRHO_PLUGIN_USE_UI_STREAM
+static void* lv2_get_ui_stream(LV2_Handle instance)
+{
+    return instancePtr->lv2_get_ui_stream();
+}
+# endif
 #endif
 
 // -----------------------------------------------------------------------
@@ -1191,6 +1286,17 @@ static const void* lv2_extension_data(const char* uri)
 
     if (std::strcmp(uri, DISTRHO_PLUGIN_LV2_STATE_PREFIX "direct-access") == 0)
         return &directaccess;
+
+# if DISTRHO_PLUGIN_USE_UI_STREAM
+    struct LV2_UIStream_Interface {
+        void* (*get_ui_stream)(LV2_Handle handle);
+    };
+
+    static const LV2_UIStream_Interface uistream = { lv2_get_ui_stream };
+
+    if (std::strcmp(uri, DISTRHO_PLUGIN_LV2_STATE_PREFIX "ui-stream") == 0)
+        return &uistream;
+# endif
 #endif
 
     return nullptr;
@@ -63,8 +63,9 @@
 # define DISTRHO_LV2_UI_TYPE "UI"
 #endif
 
+#define DISTRHO_LV2_USE_UI_STREAM  (DISTRHO_PLUGIN_WANT_UI_STREAM && DISTRHO_PLUGIN_HAS_UI && ! DISTRHO_PLUGIN_WANT_DIRECT_ACCESS)
 #define DISTRHO_LV2_USE_EVENTS_IN  (DISTRHO_PLUGIN_WANT_MIDI_INPUT || DISTRHO_PLUGIN_WANT_TIMEPOS || (DISTRHO_PLUGIN_WANT_STATE && DISTRHO_PLUGIN_HAS_UI))
-#define DISTRHO_LV2_USE_EVENTS_OUT (DISTRHO_PLUGIN_WANT_MIDI_OUTPUT || (DISTRHO_PLUGIN_WANT_STATE && DISTRHO_PLUGIN_HAS_UI))
+#define DISTRHO_LV2_USE_EVENTS_OUT (DISTRHO_PLUGIN_WANT_MIDI_OUTPUT || (DISTRHO_PLUGIN_WANT_STATE && DISTRHO_PLUGIN_HAS_UI) || DISTRHO_LV2_USE_UI_STREAM)
 
 // -----------------------------------------------------------------------
 
@@ -188,7 +189,7 @@ void lv2_generate_ttl(const char* const basename)
         String pluginString;
 
         // header
-#if DISTRHO_LV2_USE_EVENTS_IN
+#if DISTRHO_LV2_USE_EVENTS_IN || DISTRHO_LV2_USE_EVENTS_OUT
         pluginString += "@prefix atom: <" LV2_ATOM_PREFIX "> .\n";
 #endif
         pluginString += "@prefix doap: <http://usefulinc.com/ns/doap#> .\n";
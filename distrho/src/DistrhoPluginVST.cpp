@@ -55,9 +55,20 @@
 #define kPlugCategEffect 1
 #define kPlugCategSynth 2
 #define kVstVersion 2400
+#define kVstSysExType 6
 struct ERect {
     int16_t top, left, bottom, right;
 };
+struct VstMidiSysexEvent {
+    int32_t  type;
+    int32_t  byteSize;
+    int32_t  deltaFrames;
+    int32_t  flags;
+    int32_t  dumpBytes;
+    intptr_t resvd1;
+    char*    sysexDump;
+    intptr_t resvd2;
+};
 #else
 # include "vst/aeffectx.h"
 #endif
@@ -80,6 +91,66 @@ void snprintf_param(char* const dst, const float value, const size_t size)
     dst[size-1] = '\0';
 }
 
+#if DISTRHO_PLUGIN_WANT_STATE
+// -----------------------------------------------------------------------
+// State chunk format
+//
+// header: 4 bytes magic, 4 bytes version, 4 bytes entry count
+// each entry: 4 bytes key length, key, NUL, 4 bytes value length, value, NUL
+//
+// Numbers are little-endian. Strings keep their NUL terminator so they can be used in-place.
+// Old chunks are plain "key\0value\0" lists, which never start with 0xff.
+
+static const char     kStateChunkMagic[4]   = { '\xff', 'D', 'P', 'F' };
+static const uint32_t kStateChunkVersion    = 1;
+static const uint32_t kStateChunkHeaderSize = 12;
+
+static inline
+char* writeChunkUInt32(char* const buf, const uint32_t value)
+{
+    buf[0] = static_cast<char>(value & 0xff);
+    buf[1] = static_cast<char>((value >> 8) & 0xff);
+    buf[2] = static_cast<char>((value >> 16) & 0xff);
+    buf[3] = static_cast<char>((value >> 24) & 0xff);
+    return buf + 4;
+}
+
+static inline
+char* writeChunkString(char* buf, const String& str)
+{
+    const std::size_t length(str.length());
+
+    buf = writeChunkUInt32(buf, static_cast<uint32_t>(length));
+    std::memcpy(buf, str.buffer(), length);
+    buf[length] = '\0';
+    return buf + length + 1;
+}
+
+static inline
+uint32_t readChunkUInt32(const char* const buf)
+{
+    const uint8_t* const ubuf = (const uint8_t*)buf;
+    return uint32_t(ubuf[0]) | (uint32_t(ubuf[1]) << 8) | (uint32_t(ubuf[2]) << 16) | (uint32_t(ubuf[3]) << 24);
+}
+
+static inline
+bool readChunkString(const char*& buf, const char* const end, const char*& str)
+{
+    if (end - buf < 4)
+        return false;
+
+    const uint32_t length(readChunkUInt32(buf));
+    buf += 4;
+
+    if (static_cast<std::size_t>(end - buf) <= length || buf[length] != '\0')
+        return false;
+
+    str  = buf;
+    buf += length + 1;
+    return true;
+}
+#endif
+
 #if DISTRHO_PLUGIN_HAS_UI
 // -----------------------------------------------------------------------
 
@@ -87,8 +158,13 @@ class UiHelper
 {
 public:
     UiHelper()
-        : parameterChecks(nullptr),
-          parameterValues(nullptr) {}
+        : parameterCount(0),
+          parameterChecks(nullptr),
+          parameterValues(nullptr),
+          parameterQueue(nullptr),
+          parameterQueueMask(0),
+          parameterQueueWritePos(0),
+          parameterQueueReadPos(0) {}
 
     virtual ~UiHelper()
     {
@@ -102,11 +178,90 @@ public:
             delete[] parameterValues;
             parameterValues = nullptr;
         }
+        if (parameterQueue != nullptr)
+        {
+            delete[] parameterQueue;
+            parameterQueue = nullptr;
+        }
     }
 
-    bool*   parameterChecks;
-    float*  parameterValues;
+    void initParameters(const uint32_t count)
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(parameterCount == 0,);
+
+        if (count == 0)
+            return;
+
+        // power of 2 size, so queue positions stay valid when wrapping around
+        const uint32_t queueSize = d_nextPowerOf2(count);
+
+        parameterCount     = count;
+        parameterChecks    = new bool[count];
+        parameterValues    = new float[count];
+        parameterQueue     = new uint32_t[queueSize];
+        parameterQueueMask = queueSize - 1;
 
+        for (uint32_t i=0; i < count; ++i)
+        {
+            parameterChecks[i] = false;
+            parameterValues[i] = 0.0f;
+        }
+
+        for (uint32_t i=0; i < queueSize; ++i)
+            parameterQueue[i] = 0;
+    }
+
+    /*
+     * Queue a parameter change for the UI, called from host or audio thread.
+     * Changes coalesce until the next idle, each index is queued at most once,
+     * so the queue never holds more than parameterCount entries.
+     * May be called from several threads at once.
+     */
+    void queueParameterChange(const uint32_t index, const float realValue)
+    {
+        parameterValues[index] = realValue;
+
+        if (__atomic_exchange_n(&parameterChecks[index], true, __ATOMIC_ACQ_REL))
+            return;
+
+        // slots store index+1, 0 means not written yet
+        const uint32_t pos = __atomic_fetch_add(&parameterQueueWritePos, 1, __ATOMIC_RELAXED);
+        __atomic_store_n(&parameterQueue[pos & parameterQueueMask], index+1, __ATOMIC_RELEASE);
+    }
+
+    /*
+     * Get the next changed parameter, called from the UI thread.
+     */
+    bool popParameterChange(uint32_t& index, float& realValue)
+    {
+        if (parameterCount == 0)
+            return false;
+
+        uint32_t& slot(parameterQueue[parameterQueueReadPos & parameterQueueMask]);
+        const uint32_t value = __atomic_load_n(&slot, __ATOMIC_ACQUIRE);
+
+        if (value == 0)
+            return false;
+
+        __atomic_store_n(&slot, 0, __ATOMIC_RELAXED);
+        index = value-1;
+        ++parameterQueueReadPos;
+
+        __atomic_store_n(&parameterChecks[index], false, __ATOMIC_RELEASE);
+        realValue = parameterValues[index];
+        return true;
+    }
+
+private:
+    uint32_t  parameterCount;
+    bool*     parameterChecks;
+    float*    parameterValues;
+    uint32_t* parameterQueue;
+    uint32_t  parameterQueueMask;
+    uint32_t  parameterQueueWritePos;
+    uint32_t  parameterQueueReadPos;
+
+public:
 # if DISTRHO_PLUGIN_WANT_STATE
     virtual void setStateFromUI(const char* const newKey, const char* const newValue) = 0;
 # endif
@@ -124,20 +279,20 @@ public:
           fPlugin(plugin),
           fUI(this, winId, editParameterCallback, setParameterCallback, setStateCallback, sendNoteCallback, setSizeCallback, plugin->getInstancePointer())
     {
+#if DISTRHO_PLUGIN_USE_UI_STREAM
+        fUI.setUIStream(plugin->getUIStream());
+#endif
     }
 
     // -------------------------------------------------------------------
 
     void idle()
     {
-        for (uint32_t i=0, count = fPlugin->getParameterCount(); i < count; ++i)
-        {
-            if (fUiHelper->parameterChecks[i])
-            {
-                fUiHelper->parameterChecks[i] = false;
-                fUI.parameterChanged(i, fUiHelper->parameterValues[i]);
-            }
-        }
+        uint32_t index;
+        float    value;
+
+        while (fUiHelper->popParameterChange(index, value))
+            fUI.parameterChanged(index, value);
 
         fUI.idle();
     }
@@ -278,12 +433,23 @@ public:
     PluginVst(const audioMasterCallback audioMaster, AEffect* const effect)
         : fAudioMaster(audioMaster),
           fEffect(effect)
+#if DISTRHO_PLUGIN_WANT_TIMEPOS
+        , fPlugin(this, nullptr, updateTimePosCallback)
+#endif
     {
         std::memset(fProgramName, 0, sizeof(char)*(32+1));
         std::strcpy(fProgramName, "Default");
 
 #if DISTRHO_PLUGIN_WANT_MIDI_INPUT
         fMidiEventCount = 0;
+        fMidiEventsNeedSort = false;
+#endif
+
+#if DISTRHO_PLUGIN_WANT_TIMEPOS
+        // invalid flags, so the first block always does a full update
+        std::memset(&fLastTimeInfo, 0, sizeof(fLastTimeInfo));
+        fLastTimeInfo.flags = -1;
+        fTimePositionFrames = 0;
 #endif
 
 #if DISTRHO_PLUGIN_HAS_UI
@@ -293,17 +459,7 @@ public:
         fVstRect.bottom = 0;
         fVstRect.right  = 0;
 
-        if (const uint32_t paramCount = fPlugin.getParameterCount())
-        {
-            parameterChecks = new bool[paramCount];
-            parameterValues = new float[paramCount];
-
-            for (uint32_t i=0; i < paramCount; ++i)
-            {
-                parameterChecks[i] = false;
-                parameterValues[i] = 0.0f;
-            }
-        }
+        initParameters(fPlugin.getParameterCount());
 # if DISTRHO_OS_MAC
 #  ifdef __LP64__
         fUsingNsView = true;
@@ -316,6 +472,7 @@ public:
 
 #if DISTRHO_PLUGIN_WANT_STATE
         fStateChunk = nullptr;
+        fStateChunkSize = 0;
 
         for (uint32_t i=0, count=fPlugin.getStateCount(); i<count; ++i)
         {
@@ -340,10 +497,6 @@ public:
 
     intptr_t vst_dispatcher(const int32_t opcode, const int32_t index, const intptr_t value, void* const ptr, const float opt)
     {
-#if DISTRHO_PLUGIN_WANT_STATE
-        intptr_t ret = 0;
-#endif
-
         switch (opcode)
         {
         case effGetProgram:
@@ -399,6 +552,7 @@ public:
             {
 #if DISTRHO_PLUGIN_WANT_MIDI_INPUT
                 fMidiEventCount = 0;
+                fMidiEventsNeedSort = false;
 
                 // tell host we want MIDI events
                 hostCallback(audioMasterWantMidi);
@@ -503,73 +657,59 @@ public:
 
 #if DISTRHO_PLUGIN_WANT_STATE
         case effGetChunk:
+        {
             if (ptr == nullptr)
                 return 0;
 
-            if (fStateChunk != nullptr)
-            {
-                delete[] fStateChunk;
-                fStateChunk = nullptr;
-            }
-
-            if (fPlugin.getStateCount() == 0)
-            {
-                fStateChunk    = new char[1];
-                fStateChunk[0] = '\0';
-                ret = 1;
-            }
-            else
-            {
 # if DISTRHO_PLUGIN_WANT_FULL_STATE
-                // Update current state
-                for (StringMap::const_iterator cit=fStateMap.begin(), cite=fStateMap.end(); cit != cite; ++cit)
-                {
-                    const String& key = cit->first;
-                    fStateMap[key] = fPlugin.getState(key);
-                }
+            // Update current state
+            for (StringMap::iterator it=fStateMap.begin(), ite=fStateMap.end(); it != ite; ++it)
+                it->second = fPlugin.getState(it->first);
 # endif
 
-                String chunkStr;
-
-                for (StringMap::const_iterator cit=fStateMap.begin(), cite=fStateMap.end(); cit != cite; ++cit)
-                {
-                    const String& key   = cit->first;
-                    const String& value = cit->second;
+            // calculate size first, so the chunk is only reallocated when it grows
+            std::size_t chunkSize = kStateChunkHeaderSize;
 
-                    // join key and value
-                    String tmpStr;
-                    tmpStr  = key;
-                    tmpStr += "\xff";
-                    tmpStr += value;
-                    tmpStr += "\xff";
+            for (StringMap::const_iterator cit=fStateMap.begin(), cite=fStateMap.end(); cit != cite; ++cit)
+                chunkSize += 4 + cit->first.length() + 1 + 4 + cit->second.length() + 1;
 
-                    chunkStr += tmpStr;
-                }
-
-                const std::size_t chunkSize(chunkStr.length()+1);
+            if (chunkSize > fStateChunkSize)
+            {
+                delete[] fStateChunk;
+                fStateChunk     = new char[chunkSize];
+                fStateChunkSize = chunkSize;
+            }
 
-                fStateChunk = new char[chunkSize];
-                std::memcpy(fStateChunk, chunkStr.buffer(), chunkStr.length());
-                fStateChunk[chunkSize-1] = '\0';
+            char* buf = fStateChunk;
 
-                for (std::size_t i=0; i<chunkSize; ++i)
-                {
-                    if (fStateChunk[i] == '\xff')
-                        fStateChunk[i] = '\0';
-                }
+            std::memcpy(buf, kStateChunkMagic, 4);
+            buf = writeChunkUInt32(buf + 4, kStateChunkVersion);
+            buf = writeChunkUInt32(buf, static_cast<uint32_t>(fStateMap.size()));
 
-                ret = chunkSize;
+            for (StringMap::const_iterator cit=fStateMap.begin(), cite=fStateMap.end(); cit != cite; ++cit)
+            {
+                buf = writeChunkString(buf, cit->first);
+                buf = writeChunkString(buf, cit->second);
             }
 
+            DISTRHO_SAFE_ASSERT(buf == fStateChunk + chunkSize);
+
             *(void**)ptr = fStateChunk;
-            return ret;
+            return static_cast<intptr_t>(chunkSize);
+        }
 
         case effSetChunk:
         {
             if (value <= 1 || ptr == nullptr)
                 return 0;
 
-            const char* key   = (const char*)ptr;
+            const char* const chunk = (const char*)ptr;
+
+            if (static_cast<std::size_t>(value) >= kStateChunkHeaderSize && std::memcmp(chunk, kStateChunkMagic, 4) == 0)
+                return loadStateChunk(chunk, static_cast<std::size_t>(value)) ? 1 : 0;
+
+            // old format, NUL separated key and value pairs
+            const char* key   = chunk;
             const char* value = nullptr;
 
             for (;;)
@@ -579,12 +719,7 @@ public:
 
                 value = key+(std::strlen(key)+1);
 
-                setStateFromUI(key, value);
-
-# if DISTRHO_PLUGIN_HAS_UI
-                if (fVstUI != nullptr)
-                    fVstUI->setStateFromPlugin(key, value);
-# endif
+                setStateFromChunk(key, value);
 
                 // get next key
                 key = value+(std::strlen(value)+1);
@@ -607,21 +742,57 @@ public:
                 if (events->numEvents == 0)
                     break;
 
+                // host may call this more than once per block, keep appending
+                uint32_t lastFrame = fMidiEventCount > 0 ? fMidiEvents[fMidiEventCount-1].frame : 0;
+
                 for (int i=0, count=events->numEvents; i < count; ++i)
                 {
                     const VstMidiEvent* const vstMidiEvent((const VstMidiEvent*)events->events[i]);
 
                     if (vstMidiEvent == nullptr)
                         break;
-                    if (vstMidiEvent->type != kVstMidiType)
+
+                    MidiEvent tmpEvent;
+                    tmpEvent.frame   = vstMidiEvent->deltaFrames > 0 ? vstMidiEvent->deltaFrames : 0;
+                    tmpEvent.dataExt = nullptr;
+
+                    if (vstMidiEvent->type == kVstMidiType)
+                    {
+                        tmpEvent.size = getMidiEventSize(vstMidiEvent->midiData[0]);
+                        std::memcpy(tmpEvent.data, vstMidiEvent->midiData, sizeof(uint8_t)*MidiEvent::kDataSize);
+                    }
+                    else if (vstMidiEvent->type == kVstSysExType)
+                    {
+                        const VstMidiSysexEvent* const vstSysexEvent((const VstMidiSysexEvent*)vstMidiEvent);
+
+                        if (vstSysexEvent->dumpBytes <= 0 || vstSysexEvent->sysexDump == nullptr)
+                            continue;
+
+                        // host data stays valid until the next process call, no need to copy
+                        tmpEvent.size = vstSysexEvent->dumpBytes;
+                        std::memset(tmpEvent.data, 0, sizeof(uint8_t)*MidiEvent::kDataSize);
+
+                        if (tmpEvent.size > MidiEvent::kDataSize)
+                            tmpEvent.dataExt = (const uint8_t*)vstSysexEvent->sysexDump;
+                        else
+                            std::memcpy(tmpEvent.data, vstSysexEvent->sysexDump, tmpEvent.size);
+                    }
+                    else
+                    {
                         continue;
-                    if (fMidiEventCount >= kMaxMidiEvents)
-                        break;
+                    }
 
-                    MidiEvent& midiEvent(fMidiEvents[fMidiEventCount++]);
-                    midiEvent.frame  = vstMidiEvent->deltaFrames;
-                    midiEvent.size   = 3;
-                    std::memcpy(midiEvent.data, vstMidiEvent->midiData, sizeof(uint8_t)*3);
+                    MidiEvent* const midiEvent(getNextMidiEvent(d_isMidiNoteOff(tmpEvent)));
+
+                    if (midiEvent == nullptr)
+                        continue;
+
+                    *midiEvent = tmpEvent;
+
+                    if (tmpEvent.frame < lastFrame)
+                        fMidiEventsNeedSort = true;
+                    else
+                        lastFrame = tmpEvent.frame;
                 }
             }
             break;
@@ -710,50 +881,18 @@ public:
         }
 
 #if DISTRHO_PLUGIN_WANT_TIMEPOS
-        static const int kWantVstTimeFlags(kVstTransportPlaying|kVstPpqPosValid|kVstTempoValid|kVstTimeSigValid);
+        // queried later, only if the plugin asks for it
+        fTimePositionFrames = sampleFrames;
+        fPlugin.invalidateTimePosition();
+#endif
 
-        if (const VstTimeInfo* const vstTimeInfo = (const VstTimeInfo*)hostCallback(audioMasterGetTime, 0, kWantVstTimeFlags))
+#if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+        if (fMidiEventsNeedSort)
         {
-            fTimePosition.frame     =   vstTimeInfo->samplePos;
-            fTimePosition.playing   =  (vstTimeInfo->flags & kVstTransportPlaying);
-            fTimePosition.bbt.valid = ((vstTimeInfo->flags & kVstTempoValid) != 0 || (vstTimeInfo->flags & kVstTimeSigValid) != 0);
-
-            // ticksPerBeat is not possible with VST
-            fTimePosition.bbt.ticksPerBeat = 960.0;
-
-            if (vstTimeInfo->flags & kVstTempoValid)
-                fTimePosition.bbt.beatsPerMinute = vstTimeInfo->tempo;
-            else
-                fTimePosition.bbt.beatsPerMinute = 120.0;
-
-            if (vstTimeInfo->flags & (kVstPpqPosValid|kVstTimeSigValid))
-            {
-                const int    ppqPerBar = vstTimeInfo->timeSigNumerator * 4 / vstTimeInfo->timeSigDenominator;
-                const double barBeats  = (std::fmod(vstTimeInfo->ppqPos, ppqPerBar) / ppqPerBar) * vstTimeInfo->timeSigDenominator;
-                const double rest      =  std::fmod(barBeats, 1.0);
-
-                fTimePosition.bbt.bar         = int(vstTimeInfo->ppqPos)/ppqPerBar + 1;
-                fTimePosition.bbt.beat        = barBeats-rest+1;
-                fTimePosition.bbt.tick        = rest*fTimePosition.bbt.ticksPerBeat+0.5;
-                fTimePosition.bbt.beatsPerBar = vstTimeInfo->timeSigNumerator;
-                fTimePosition.bbt.beatType    = vstTimeInfo->timeSigDenominator;
-            }
-            else
-            {
-                fTimePosition.bbt.bar         = 1;
-                fTimePosition.bbt.beat        = 1;
-                fTimePosition.bbt.tick        = 0;
-                fTimePosition.bbt.beatsPerBar = 4.0f;
-                fTimePosition.bbt.beatType    = 4.0f;
-            }
-
-            fTimePosition.bbt.barStartTick = fTimePosition.bbt.ticksPerBeat*fTimePosition.bbt.beatsPerBar*(fTimePosition.bbt.bar-1);
-
-            fPlugin.setTimePosition(fTimePosition);
+            d_sortMidiEvents(fMidiEvents, fMidiEventCount);
+            fMidiEventsNeedSort = false;
         }
-#endif
 
-#if DISTRHO_PLUGIN_WANT_MIDI_INPUT
         fPlugin.run(inputs, outputs, sampleFrames, fMidiEvents, fMidiEventCount);
         fMidiEventCount = 0;
 #else
@@ -774,6 +913,104 @@ public:
 
     // -------------------------------------------------------------------
 
+#if DISTRHO_PLUGIN_WANT_TIMEPOS
+    void updateTimePosition()
+    {
+        static const int kWantVstTimeFlags(kVstTransportPlaying|kVstPpqPosValid|kVstTempoValid|kVstTimeSigValid);
+
+        if (const VstTimeInfo* const vstTimeInfo = (const VstTimeInfo*)hostCallback(audioMasterGetTime, 0, kWantVstTimeFlags))
+        {
+            const int32_t flags(vstTimeInfo->flags & kWantVstTimeFlags);
+
+            const bool sameSettings = flags == fLastTimeInfo.flags
+                                   && d_isEqual(vstTimeInfo->tempo, fLastTimeInfo.tempo)
+                                   && vstTimeInfo->timeSigNumerator == fLastTimeInfo.timeSigNumerator
+                                   && vstTimeInfo->timeSigDenominator == fLastTimeInfo.timeSigDenominator;
+
+            // hosts can loop or relocate the musical position without a jump in samplePos,
+            // so ppqPos must also be where it would be without a change, within one tick
+            static const double kPpqTolerance = 1.0 / 960.0;
+
+            const bool ppqValid = (flags & kVstPpqPosValid) != 0;
+            const double ppqAdvance = fLastTimeInfo.frames * vstTimeInfo->tempo / (60.0 * fPlugin.getSampleRate());
+
+            if (sameSettings && d_isEqual(vstTimeInfo->samplePos, fLastTimeInfo.samplePos) &&
+                (! ppqValid || std::abs(vstTimeInfo->ppqPos - fLastTimeInfo.ppqPos) < kPpqTolerance))
+            {
+                // transport stopped, nothing changed
+            }
+            else if (sameSettings && fTimePosition.playing &&
+                     std::abs(vstTimeInfo->samplePos - (fLastTimeInfo.samplePos + fLastTimeInfo.frames)) < 0.5 &&
+                     (! ppqValid || std::abs(vstTimeInfo->ppqPos - (fLastTimeInfo.ppqPos + ppqAdvance)) < kPpqTolerance))
+            {
+                // continuous playback, extrapolate from the previous block
+                fTimeExtrapolator.advance(fLastTimeInfo.frames, fPlugin.getSampleRate());
+                fTimePosition = fTimeExtrapolator.getPosition();
+
+                fPlugin.setTimePosition(fTimeExtrapolator);
+            }
+            else
+            {
+                fTimePosition.frame     =   vstTimeInfo->samplePos;
+                fTimePosition.playing   =  (vstTimeInfo->flags & kVstTransportPlaying);
+                fTimePosition.bbt.valid = ((vstTimeInfo->flags & kVstTempoValid) != 0 || (vstTimeInfo->flags & kVstTimeSigValid) != 0);
+
+                // ticksPerBeat is not possible with VST
+                fTimePosition.bbt.ticksPerBeat = 960.0;
+
+                if (vstTimeInfo->flags & kVstTempoValid)
+                    fTimePosition.bbt.beatsPerMinute = vstTimeInfo->tempo;
+                else
+                    fTimePosition.bbt.beatsPerMinute = 120.0;
+
+                double barBeats = 0.0;
+
+                if (vstTimeInfo->flags & (kVstPpqPosValid|kVstTimeSigValid))
+                {
+                    const double ppqPerBar = vstTimeInfo->timeSigNumerator * 4.0 / vstTimeInfo->timeSigDenominator;
+                    barBeats = (std::fmod(vstTimeInfo->ppqPos, ppqPerBar) / ppqPerBar) * vstTimeInfo->timeSigNumerator;
+                    const double rest = std::fmod(barBeats, 1.0);
+
+                    fTimePosition.bbt.bar         = int(vstTimeInfo->ppqPos / ppqPerBar) + 1;
+                    fTimePosition.bbt.beat        = barBeats-rest+1;
+                    fTimePosition.bbt.tick        = rest*fTimePosition.bbt.ticksPerBeat+0.5;
+                    fTimePosition.bbt.beatsPerBar = vstTimeInfo->timeSigNumerator;
+                    fTimePosition.bbt.beatType    = vstTimeInfo->timeSigDenominator;
+                }
+                else
+                {
+                    fTimePosition.bbt.bar         = 1;
+                    fTimePosition.bbt.beat        = 1;
+                    fTimePosition.bbt.tick        = 0;
+                    fTimePosition.bbt.beatsPerBar = 4.0f;
+                    fTimePosition.bbt.beatType    = 4.0f;
+                }
+
+                fTimePosition.bbt.barStartTick = fTimePosition.bbt.ticksPerBeat*fTimePosition.bbt.beatsPerBar*(fTimePosition.bbt.bar-1);
+
+                // VST tempo is in quarter notes, beats are in beatType units
+                fTimeExtrapolator.setPosition(fTimePosition, barBeats,
+                                              fTimePosition.bbt.beatsPerMinute * fTimePosition.bbt.beatType / 4.0);
+
+                fPlugin.setTimePosition(fTimeExtrapolator);
+            }
+
+            fLastTimeInfo.flags              = flags;
+            fLastTimeInfo.samplePos          = vstTimeInfo->samplePos;
+            fLastTimeInfo.ppqPos             = vstTimeInfo->ppqPos;
+            fLastTimeInfo.tempo              = vstTimeInfo->tempo;
+            fLastTimeInfo.timeSigNumerator   = vstTimeInfo->timeSigNumerator;
+            fLastTimeInfo.timeSigDenominator = vstTimeInfo->timeSigDenominator;
+            fLastTimeInfo.frames             = fTimePositionFrames;
+        }
+    }
+
+    static void updateTimePosCallback(void* ptr)
+    {
+        ((PluginVst*)ptr)->updateTimePosition();
+    }
+#endif
+
     friend class UIVst;
 
 private:
@@ -790,10 +1027,26 @@ private:
 #if DISTRHO_PLUGIN_WANT_MIDI_INPUT
     uint32_t  fMidiEventCount;
     MidiEvent fMidiEvents[kMaxMidiEvents];
+    bool      fMidiEventsNeedSort;
 #endif
 
 #if DISTRHO_PLUGIN_WANT_TIMEPOS
     TimePosition fTimePosition;
+    TimePositionExtrapolator fTimeExtrapolator;
+
+    // last host time info, used to detect transport changes
+    struct LastTimeInfo {
+        int32_t  flags;
+        double   samplePos;
+        double   ppqPos;
+        double   tempo;
+        int32_t  timeSigNumerator;
+        int32_t  timeSigDenominator;
+        uint32_t frames;
+    } fLastTimeInfo;
+
+    // size of the current block, for when the time position is fetched
+    uint32_t fTimePositionFrames;
 #endif
 
     // UI stuff
@@ -806,8 +1059,9 @@ private:
 #endif
 
 #if DISTRHO_PLUGIN_WANT_STATE
-    char*     fStateChunk;
-    StringMap fStateMap;
+    char*       fStateChunk;
+    std::size_t fStateChunkSize;
+    StringMap   fStateMap;
 #endif
 
     // -------------------------------------------------------------------
@@ -822,14 +1076,62 @@ private:
         return fAudioMaster(fEffect, opcode, index, value, ptr, opt);
     }
 
+#if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+    // -------------------------------------------------------------------
+    // MIDI input, RT no block
+
+    static uint32_t getMidiEventSize(const char status)
+    {
+        switch (static_cast<uint8_t>(status) & 0xF0)
+        {
+        case 0xC0:
+        case 0xD0:
+            return 2;
+        case 0xF0:
+            switch (static_cast<uint8_t>(status))
+            {
+            case 0xF1:
+            case 0xF3:
+                return 2;
+            case 0xF2:
+                return 3;
+            default:
+                return 1;
+            }
+        default:
+            return 3;
+        }
+    }
+
+    MidiEvent* getNextMidiEvent(const bool isNoteOff)
+    {
+        if (fMidiEventCount < kMaxMidiEvents)
+            return &fMidiEvents[fMidiEventCount++];
+
+        // buffer full, drop new events but make room for note-offs so no notes are left hanging
+        if (! isNoteOff)
+            return nullptr;
+
+        for (uint32_t i=kMaxMidiEvents; i-- > 0;)
+        {
+            if (d_isMidiNoteOff(fMidiEvents[i]))
+                continue;
+
+            fMidiEventsNeedSort = true;
+            return &fMidiEvents[i];
+        }
+
+        return nullptr;
+    }
+#endif
+
     // -------------------------------------------------------------------
     // functions called from the plugin side, RT no block
 
 #if DISTRHO_PLUGIN_HAS_UI
     void setParameterValueFromPlugin(const uint32_t index, const float realValue)
     {
-        parameterValues[index] = realValue;
-        parameterChecks[index] = true;
+        queueParameterChange(index, realValue);
     }
 #endif
 
@@ -863,6 +1165,48 @@ private:
 
         d_stderr("Failed to find plugin state with key \"%s\"", key);
     }
+
+    // -------------------------------------------------------------------
+    // state chunk loading, called from the host
+
+    void setStateFromChunk(const char* const key, const char* const newValue)
+    {
+        setStateFromUI(key, newValue);
+
+# if DISTRHO_PLUGIN_HAS_UI
+        if (fVstUI != nullptr)
+            fVstUI->setStateFromPlugin(key, newValue);
+# endif
+    }
+
+    bool loadStateChunk(const char* const chunk, const std::size_t size)
+    {
+        const uint32_t version(readChunkUInt32(chunk + 4));
+
+        if (version != kStateChunkVersion)
+        {
+            d_stderr("Unsupported state chunk version %u", version);
+            return false;
+        }
+
+        const char* buf = chunk + kStateChunkHeaderSize;
+        const char* const end = chunk + size;
+        const char* key;
+        const char* value;
+
+        for (uint32_t i=0, count=readChunkUInt32(chunk + 8); i < count; ++i)
+        {
+            if (! readChunkString(buf, end, key) || ! readChunkString(buf, end, value))
+            {
+                d_stderr("Invalid state chunk");
+                return false;
+            }
+
+            setStateFromChunk(key, value);
+        }
+
+        return true;
+    }
 #endif
 };
 
@@ -1080,6 +1424,9 @@ const AEffect* VSTPluginMain(audioMasterCallback audioMaster)
     vst_dispatcherCallback(nullptr, -1729, 0xdead, 0xf00d, &plugin, 0.0f);
     DISTRHO_SAFE_ASSERT_RETURN(plugin != nullptr, nullptr);
 
+    if (! plugin->isValid())
+        return nullptr;
+
     AEffect* const effect(new AEffect);
     std::memset(effect, 0, sizeof(AEffect));
 
@@ -89,6 +89,18 @@ void UI::sendNote(uint8_t channel, uint8_t note, uint8_t velocity)
 }
 #endif
 
+#if DISTRHO_PLUGIN_WANT_UI_STREAM
+uint32_t UI::readUIStream(float* data, uint32_t count)
+{
+    DISTRHO_SAFE_ASSERT_RETURN(data != nullptr, 0);
+
+    if (pData->uiStream == nullptr)
+        return 0;
+
+    return pData->uiStream->read(data, count);
+}
+#endif
+
 #if DISTRHO_PLUGIN_WANT_DIRECT_ACCESS
 /* ------------------------------------------------------------------------------------------------------------
  * Direct DSP access */
@@ -62,6 +62,30 @@ struct OscData {
         lo_send(addr, targetPath, "if", index, value);
     }
 
+    void send_controls(const int32_t* const indexes, const float* const values, const uint32_t count) const
+    {
+        if (count == 1)
+            return send_control(indexes[0], values[0]);
+
+        char targetPath[std::strlen(path)+9];
+        std::strcpy(targetPath, path);
+        std::strcat(targetPath, "/control");
+
+        // one packet for all changes, dispatched by the host as individual messages
+        const lo_bundle bundle = lo_bundle_new(LO_TT_IMMEDIATE);
+
+        for (uint32_t i=0; i < count; ++i)
+        {
+            const lo_message message = lo_message_new();
+            lo_message_add_int32(message, indexes[i]);
+            lo_message_add_float(message, values[i]);
+            lo_bundle_add_message(bundle, targetPath, message);
+        }
+
+        lo_send_bundle(addr, bundle);
+        lo_bundle_free_messages(bundle);
+    }
+
     void send_midi(uchar data[4]) const
     {
         char targetPath[std::strlen(path)+6];
@@ -95,7 +119,8 @@ public:
     UIDssi(const OscData& oscData, const char* const uiTitle)
         : fUI(this, 0, nullptr, setParameterCallback, setStateCallback, sendNoteCallback, setSizeCallback),
           fHostClosed(false),
-          fOscData(oscData)
+          fOscData(oscData),
+          fPendingControlCount(0)
     {
         fUI.setWindowTitle(uiTitle);
     }
@@ -103,7 +128,10 @@ public:
     ~UIDssi()
     {
         if (fOscData.server != nullptr && ! fHostClosed)
+        {
+            flushControls();
             fOscData.send_exiting();
+        }
     }
 
     void exec()
@@ -115,6 +143,7 @@ public:
             if (fHostClosed || ! fUI.idle())
                 break;
 
+            flushControls();
             d_msleep(30);
         }
     }
@@ -169,7 +198,22 @@ protected:
         if (fOscData.server == nullptr)
             return;
 
-        fOscData.send_control(rindex, value);
+        // only the last value of each control is sent per idle tick
+        for (uint32_t i=0; i < fPendingControlCount; ++i)
+        {
+            if (fPendingControlIndexes[i] == static_cast<int32_t>(rindex))
+            {
+                fPendingControlValues[i] = value;
+                return;
+            }
+        }
+
+        if (fPendingControlCount == kMaxPendingControls)
+            flushControls();
+
+        fPendingControlIndexes[fPendingControlCount] = rindex;
+        fPendingControlValues[fPendingControlCount]  = value;
+        ++fPendingControlCount;
     }
 
     void setState(const char* const key, const char* const value)
@@ -177,6 +221,7 @@ protected:
         if (fOscData.server == nullptr)
             return;
 
+        flushControls();
         fOscData.send_configure(key, value);
     }
 
@@ -190,6 +235,7 @@ protected:
         uint8_t mdata[4] = { 0, channel, note, velocity };
         mdata[1] += (velocity != 0) ? 0x90 : 0x80;
 
+        flushControls();
         fOscData.send_midi(mdata);
     }
 
@@ -204,6 +250,21 @@ private:
 
     const OscData& fOscData;
 
+    // control changes not sent yet
+    static const uint32_t kMaxPendingControls = 64;
+    uint32_t fPendingControlCount;
+    int32_t  fPendingControlIndexes[kMaxPendingControls];
+    float    fPendingControlValues[kMaxPendingControls];
+
+    void flushControls()
+    {
+        if (fPendingControlCount == 0)
+            return;
+
+        fOscData.send_controls(fPendingControlIndexes, fPendingControlValues, fPendingControlCount);
+        fPendingControlCount = 0;
+    }
+
     // -------------------------------------------------------------------
     // Callbacks
 
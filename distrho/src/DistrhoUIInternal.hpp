@@ -19,6 +19,10 @@
 
 #include "../DistrhoUI.hpp"
 
+#if DISTRHO_PLUGIN_WANT_UI_STREAM
+# include "../extra/RingBuffer.hpp"
+#endif
+
 #ifdef HAVE_DGL
 # include "../../dgl/Application.hpp"
 # include "../../dgl/Window.hpp"
@@ -59,6 +63,9 @@ struct UI::PrivateData {
 #if DISTRHO_PLUGIN_WANT_DIRECT_ACCESS
     void*    dspPtr;
 #endif
+#if DISTRHO_PLUGIN_WANT_UI_STREAM
+    RingBuffer<float>* uiStream;
+#endif
 
     // Callbacks
     editParamFunc editParamCallbackFunc;
@@ -73,6 +80,9 @@ struct UI::PrivateData {
           parameterOffset(0),
 #if DISTRHO_PLUGIN_WANT_DIRECT_ACCESS
           dspPtr(d_lastUiDspPtr),
+#endif
+#if DISTRHO_PLUGIN_WANT_UI_STREAM
+          uiStream(nullptr),
 #endif
           editParamCallbackFunc(nullptr),
           setParamCallbackFunc(nullptr),
@@ -93,9 +103,9 @@ struct UI::PrivateData {
 #ifdef DISTRHO_PLUGIN_TARGET_LV2
 # if (DISTRHO_PLUGIN_IS_SYNTH || DISTRHO_PLUGIN_WANT_TIMEPOS || DISTRHO_PLUGIN_WANT_STATE)
         parameterOffset += 1;
-#  if DISTRHO_PLUGIN_WANT_STATE
+# endif
+# if (DISTRHO_PLUGIN_WANT_STATE || (DISTRHO_PLUGIN_WANT_UI_STREAM && ! DISTRHO_PLUGIN_WANT_DIRECT_ACCESS))
         parameterOffset += 1;
-#  endif
 # endif
 #endif
     }
@@ -301,6 +311,15 @@ public:
         return fData->parameterOffset;
     }
 
+#if DISTRHO_PLUGIN_WANT_UI_STREAM
+    void setUIStream(RingBuffer<float>* const uiStream) noexcept
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(fData != nullptr,);
+
+        fData->uiStream = uiStream;
+    }
+#endif
+
     // -------------------------------------------------------------------
 
     void parameterChanged(const uint32_t index, const float value)
@@ -32,6 +32,8 @@
 # define DISTRHO_PLUGIN_LV2_STATE_PREFIX "urn:distrho:"
 #endif
 
+#define DISTRHO_LV2_USE_UI_STREAM (DISTRHO_PLUGIN_WANT_UI_STREAM && ! DISTRHO_PLUGIN_WANT_DIRECT_ACCESS)
+
 START_NAMESPACE_DISTRHO
 
 // -----------------------------------------------------------------------
@@ -51,8 +53,16 @@ public:
           fWriteFunction(writeFunc),
           fEventTransferURID(uridMap->map(uridMap->handle, LV2_ATOM__eventTransfer)),
           fKeyValueURID(uridMap->map(uridMap->handle, DISTRHO_PLUGIN_LV2_STATE_PREFIX "KeyValueState")),
+#if DISTRHO_LV2_USE_UI_STREAM
+          fUIStreamURID(uridMap->map(uridMap->handle, DISTRHO_PLUGIN_LV2_STATE_PREFIX "UIStream")),
+          fUIStream(DISTRHO_PLUGIN_UI_STREAM_SIZE),
+#endif
           fWinIdWasNull(winId == 0)
     {
+#if DISTRHO_LV2_USE_UI_STREAM
+        fUI.setUIStream(&fUIStream);
+#endif
+
         if (fUiResize != nullptr && winId != 0)
             fUiResize->ui_resize(fUiResize->handle, fUI.getWidth(), fUI.getHeight());
 
@@ -122,17 +132,26 @@ public:
             const float value(*(const float*)buffer);
             fUI.parameterChanged(rindex-parameterOffset, value);
         }
-#if DISTRHO_PLUGIN_WANT_STATE
+#if DISTRHO_PLUGIN_WANT_STATE || DISTRHO_LV2_USE_UI_STREAM
         else if (format == fEventTransferURID)
         {
             const LV2_Atom* const atom((const LV2_Atom*)buffer);
 
+# if DISTRHO_LV2_USE_UI_STREAM
+            if (atom->type == fUIStreamURID)
+            {
+                fUIStream.write((const float*)LV2_ATOM_BODY_CONST(atom), atom->size / sizeof(float));
+                return;
+            }
+# endif
+# if DISTRHO_PLUGIN_WANT_STATE
             DISTRHO_SAFE_ASSERT_RETURN(atom->type == fKeyValueURID,);
 
             const char* const key   = (const char*)LV2_ATOM_BODY_CONST(atom);
             const char* const value = key+(std::strlen(key)+1);
 
             fUI.stateChanged(key, value);
+# endif
         }
 #endif
     }
@@ -205,6 +224,13 @@ public:
     }
 #endif
 
+#if DISTRHO_PLUGIN_WANT_DIRECT_ACCESS && DISTRHO_PLUGIN_WANT_UI_STREAM
+    void setUIStream(RingBuffer<float>* const uiStream)
+    {
+        fUI.setUIStream(uiStream);
+    }
+#endif
+
     // -------------------------------------------------------------------
 
 protected:
@@ -282,6 +308,12 @@ private:
     // Need to save this
     const LV2_URID fEventTransferURID;
     const LV2_URID fKeyValueURID;
+#if DISTRHO_LV2_USE_UI_STREAM
+    const LV2_URID fUIStreamURID;
+
+    // Stream data received from DSP
+    RingBuffer<float> fUIStream;
+#endif
 
     // using ui:showInterface if true
     bool fWinIdWasNull;
@@ -342,6 +374,12 @@ static LV2UI_Handle lv2ui_instantiate(const LV2UI_Descriptor*, const char* uri,
         void* (*get_instance_pointer)(LV2_Handle handle);
     };
     const LV2_Extension_Data_Feature* extData = nullptr;
+# if DISTRHO_PLUGIN_WANT_UI_STREAM
+    struct LV2_UIStream_Interface {
+        void* (*get_ui_stream)(LV2_Handle handle);
+    };
+    void* uiStream = nullptr;
+# endif
 #endif
 
     for (int i=0; features[i] != nullptr; ++i)
@@ -386,6 +424,11 @@ static LV2UI_Handle lv2ui_instantiate(const LV2UI_Descriptor*, const char* uri,
         return nullptr;
     }
 
+# if DISTRHO_PLUGIN_WANT_UI_STREAM
+    if (const LV2_UIStream_Interface* const streamAccess = (const LV2_UIStream_Interface*)extData->data_access(DISTRHO_PLUGIN_LV2_STATE_PREFIX "ui-stream"))
+        uiStream = streamAccess->get_ui_stream(instance);
+# endif
+
     if (const LV2_DirectAccess_Interface* const directAccess = (const LV2_DirectAccess_Interface*)extData->data_access(DISTRHO_PLUGIN_LV2_STATE_PREFIX "direct-access"))
         instance = directAccess->get_instance_pointer(instance);
     else
@@ -424,7 +467,13 @@ static LV2UI_Handle lv2ui_instantiate(const LV2UI_Descriptor*, const char* uri,
         d_lastUiSampleRate = 44100.0;
     }
 
-    return new UiLv2(bundlePath, winId, options, uridMap, uiResize, uiTouch, controller, writeFunction, widget, instance);
+    UiLv2* const ui = new UiLv2(bundlePath, winId, options, uridMap, uiResize, uiTouch, controller, writeFunction, widget, instance);
+
+#if DISTRHO_PLUGIN_WANT_DIRECT_ACCESS && DISTRHO_PLUGIN_WANT_UI_STREAM
+    ui->setUIStream((RingBuffer<float>*)uiStream);
+#endif
+
+    return ui;
 }
 
 #define uiPtr ((UiLv2*)ui)
@@ -0,0 +1,255 @@
+/*
+ * DISTRHO Plugin Framework (DPF)
+ * Copyright (C) 2012-2016 Filipe Coelho <falktx@falktx.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with
+ * or without fee is hereby granted, provided that the above copyright notice and this
+ * permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+ * TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+ * NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+// Loopback measurement of the OSC traffic a DSSI UI sends to its host while a knob is dragged.
+// A host-side server and the UI-side address live in this process and talk over UDP on localhost.
+// The same simulated drag is sent once with one /control message per parameter change, like the UI used to,
+// and once coalesced per idle tick into a single bundle, like DistrhoUIDSSI.cpp does now.
+
+#include <lo/lo.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <stdint.h>
+
+#ifndef nullptr
+# define nullptr (0)
+#endif
+
+// -----------------------------------------------------------------------
+// Options
+
+struct LoopbackOptions {
+    uint32_t mouseRate;   // mouse motion events per second
+    uint32_t duration;    // drag length in milliseconds
+    uint32_t controls;    // parameter changes per mouse event, e.g. a knob and the values linked to it
+    uint32_t idleTime;    // UI idle interval in milliseconds, 30 in DistrhoUIDSSI.cpp
+
+    LoopbackOptions()
+        : mouseRate(120),
+          duration(2000),
+          controls(2),
+          idleTime(30) {}
+};
+
+static const char* const kControlPath = "/dssi/loopback/control";
+static const uint32_t kMaxControls = 64; // same as kMaxPendingControls in DistrhoUIDSSI.cpp
+
+// -----------------------------------------------------------------------
+// Host side, counts what arrives
+
+struct HostCounters {
+    uint32_t packets;
+    uint32_t messages;
+    uint32_t bytes;
+    float    lastValues[kMaxControls];
+
+    HostCounters()
+        : packets(0),
+          messages(0),
+          bytes(0)
+    {
+        std::memset(lastValues, 0, sizeof(lastValues));
+    }
+};
+
+static int controlHandler(const char*, const char*, lo_arg** argv, int, lo_message, void* userData)
+{
+    HostCounters* const counters = (HostCounters*)userData;
+    const int32_t index = argv[0]->i;
+
+    ++counters->messages;
+
+    if (index >= 0 && index < static_cast<int32_t>(kMaxControls))
+        counters->lastValues[index] = argv[1]->f;
+
+    return 0;
+}
+
+static void drainHost(const lo_server server, HostCounters& counters)
+{
+    for (int size; (size = lo_server_recv_noblock(server, 0)) > 0;)
+    {
+        ++counters.packets;
+        counters.bytes += static_cast<uint32_t>(size);
+    }
+}
+
+// -----------------------------------------------------------------------
+// UI side, mirrors OscData::send_controls() and UIDssi::flushControls()
+
+struct PendingControls {
+    uint32_t count;
+    int32_t  indexes[kMaxControls];
+    float    values[kMaxControls];
+
+    PendingControls()
+        : count(0) {}
+
+    void set(const int32_t index, const float value)
+    {
+        for (uint32_t i=0; i < count; ++i)
+        {
+            if (indexes[i] == index)
+            {
+                values[i] = value;
+                return;
+            }
+        }
+
+        indexes[count] = index;
+        values[count]  = value;
+        ++count;
+    }
+
+    void flush(const lo_address addr)
+    {
+        if (count == 0)
+            return;
+
+        if (count == 1)
+        {
+            lo_send(addr, kControlPath, "if", indexes[0], values[0]);
+        }
+        else
+        {
+            const lo_bundle bundle = lo_bundle_new(LO_TT_IMMEDIATE);
+
+            for (uint32_t i=0; i < count; ++i)
+            {
+                const lo_message message = lo_message_new();
+                lo_message_add_int32(message, indexes[i]);
+                lo_message_add_float(message, values[i]);
+                lo_bundle_add_message(bundle, kControlPath, message);
+            }
+
+            lo_send_bundle(addr, bundle);
+            lo_bundle_free_messages(bundle);
+        }
+
+        count = 0;
+    }
+};
+
+// -----------------------------------------------------------------------
+// Simulated knob drag
+
+static void runDrag(const LoopbackOptions& options, const bool coalesce, HostCounters& counters, uint32_t& changes)
+{
+    const lo_server server = lo_server_new_with_proto(nullptr, LO_UDP, nullptr);
+
+    if (server == nullptr)
+    {
+        std::printf("Failed to create OSC server\n");
+        std::exit(2);
+    }
+
+    lo_server_add_method(server, kControlPath, "if", controlHandler, &counters);
+
+    char port[16];
+    std::snprintf(port, sizeof(port), "%i", lo_server_get_port(server));
+    const lo_address addr = lo_address_new("127.0.0.1", port);
+
+    PendingControls pending;
+    const uint32_t eventCount = options.mouseRate * options.duration / 1000;
+    uint32_t nextIdle = options.idleTime;
+
+    changes = 0;
+
+    for (uint32_t e=0; e < eventCount; ++e)
+    {
+        const uint32_t time = e * 1000 / options.mouseRate;
+
+        // idle ticks are not tied to mouse events, flush every one that passed
+        for (; coalesce && time >= nextIdle; nextIdle += options.idleTime)
+        {
+            pending.flush(addr);
+            drainHost(server, counters);
+        }
+
+        for (uint32_t c=0; c < options.controls; ++c)
+        {
+            const float value = static_cast<float>(e) / static_cast<float>(eventCount) + static_cast<float>(c);
+            ++changes;
+
+            if (coalesce)
+            {
+                pending.set(static_cast<int32_t>(c), value);
+            }
+            else
+            {
+                lo_send(addr, kControlPath, "if", static_cast<int32_t>(c), value);
+                drainHost(server, counters);
+            }
+        }
+    }
+
+    pending.flush(addr);
+    drainHost(server, counters);
+
+    lo_address_free(addr);
+    lo_server_free(server);
+}
+
+// -----------------------------------------------------------------------
+
+int main(int argc, char* argv[])
+{
+    LoopbackOptions options;
+
+    for (int i=1; i < argc; ++i)
+    {
+        const char* const arg = argv[i];
+
+        if (std::strcmp(arg, "-r") == 0 && i+1 < argc)
+            options.mouseRate = static_cast<uint32_t>(std::atoi(argv[++i]));
+        else if (std::strcmp(arg, "-d") == 0 && i+1 < argc)
+            options.duration = static_cast<uint32_t>(std::atoi(argv[++i]));
+        else if (std::strcmp(arg, "-c") == 0 && i+1 < argc)
+            options.controls = static_cast<uint32_t>(std::atoi(argv[++i]));
+        else if (std::strcmp(arg, "-i") == 0 && i+1 < argc)
+            options.idleTime = static_cast<uint32_t>(std::atoi(argv[++i]));
+        else
+            options.mouseRate = 0; // invalid, show usage
+    }
+
+    if (options.mouseRate == 0 || options.idleTime == 0 || options.controls == 0 || options.controls > kMaxControls)
+    {
+        std::printf("usage: %s [-r mouse-events-per-second] [-d drag-ms] [-c controls-per-event] [-i idle-ms]\n", argv[0]);
+        return 1;
+    }
+
+    HostCounters before, after;
+    uint32_t changesBefore, changesAfter;
+
+    runDrag(options, false, before, changesBefore);
+    runDrag(options, true, after, changesAfter);
+
+    std::printf("%-11s %8s %8s %9s %8s\n", "mode", "changes", "packets", "messages", "bytes");
+    std::printf("%-11s %8u %8u %9u %8u\n", "per-change", changesBefore, before.packets, before.messages, before.bytes);
+    std::printf("%-11s %8u %8u %9u %8u\n", "coalesced", changesAfter, after.packets, after.messages, after.bytes);
+
+    // the host must end up with the same values either way
+    if (std::memcmp(before.lastValues, after.lastValues, sizeof(before.lastValues)) != 0)
+    {
+        std::printf("final control values differ\n");
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,1517 @@
+/*
+ * DISTRHO Plugin Framework (DPF)
+ * Copyright (C) 2012-2016 Filipe Coelho <falktx@falktx.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with
+ * or without fee is hereby granted, provided that the above copyright notice and this
+ * permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+ * TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+ * NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+// Minimal host for exercising DPF plugin binaries through their LV2, VST, LADSPA and DSSI entry points.
+// Each ABI found in the binary is instantiated, run with synthetic audio, MIDI and parameter changes,
+// saved and restored, while timing every call. The exit code is non-zero if any check failed.
+
+#include "../../distrho/src/dssi/dssi.h"
+#include "../../distrho/src/lv2/atom.h"
+#include "../../distrho/src/lv2/atom-util.h"
+#include "../../distrho/src/lv2/buf-size.h"
+#include "../../distrho/src/lv2/lv2.h"
+#include "../../distrho/src/lv2/midi.h"
+#include "../../distrho/src/lv2/options.h"
+#include "../../distrho/src/lv2/state.h"
+#include "../../distrho/src/lv2/urid.h"
+#include "../../distrho/src/lv2/worker.h"
+#include "../../distrho/src/vestige/aeffectx.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <dlfcn.h>
+#include <stdint.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+
+// not part of vestige, same values as in DistrhoPluginVST.cpp
+#define effFlagsProgramChunks (1 << 5)
+#define effGetChunk 23
+#define effSetChunk 24
+
+#ifndef nullptr
+# define nullptr (0)
+#endif
+
+// -----------------------------------------------------------------------
+// Options
+
+struct HostOptions {
+    uint32_t bufferSize;
+    double   sampleRate;
+    uint32_t iterations;
+    uint32_t parameterChanges; // per block
+    int      midiEvents;       // per block, or -1 for a note every few blocks
+    bool     benchmark;        // print a single line with the run timing
+    const char* onlyFormat;
+
+    HostOptions()
+        : bufferSize(512),
+          sampleRate(48000.0),
+          iterations(1000),
+          parameterChanges(1),
+          midiEvents(-1),
+          benchmark(false),
+          onlyFormat(nullptr) {}
+};
+
+static const uint32_t kMidiNoteInterval = 8;   // blocks between note-ons
+static const uint32_t kMidiNoteLength   = 4;   // blocks until the matching note-off
+static const uint32_t kMaxMidiEvents    = 512; // same as DPF
+static const uint32_t kEventBufferSize  = kMaxMidiEvents * 32;
+static const uint32_t kWorkBufferSize   = 8192;
+
+struct HostMidiEvent {
+    uint32_t frame;
+    uint8_t  data[3];
+};
+
+// -----------------------------------------------------------------------
+// Timing
+
+static uint64_t getTimeNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+enum HostCall {
+    kCallInstantiate = 0,
+    kCallActivate,
+    kCallSetParameter,
+    kCallRun,
+    kCallWork,
+    kCallSave,
+    kCallRestore,
+    kCallDeactivate,
+    kCallCleanup,
+    kCallCount
+};
+
+static const char* const kCallNames[kCallCount] = {
+    "instantiate",
+    "activate",
+    "set-parameter",
+    "run",
+    "work",
+    "save",
+    "restore",
+    "deactivate",
+    "cleanup"
+};
+
+struct CallTiming {
+    uint64_t count;
+    uint64_t total;
+    uint64_t min;
+    uint64_t max;
+
+    CallTiming()
+        : count(0),
+          total(0),
+          min(0),
+          max(0) {}
+
+    void add(const uint64_t ns)
+    {
+        if (count == 0 || ns < min)
+            min = ns;
+        if (ns > max)
+            max = ns;
+
+        total += ns;
+        ++count;
+    }
+};
+
+class ScopedTiming
+{
+public:
+    ScopedTiming(CallTiming& timing)
+        : fTiming(timing),
+          fStart(getTimeNs()) {}
+
+    ~ScopedTiming()
+    {
+        fTiming.add(getTimeNs() - fStart);
+    }
+
+private:
+    CallTiming& fTiming;
+    const uint64_t fStart;
+};
+
+// -----------------------------------------------------------------------
+// Common test sequence, each plugin ABI implements the virtual calls
+
+class PluginTest
+{
+public:
+    PluginTest(const char* const format, const HostOptions& options)
+        : fFormat(format),
+          fOptions(options),
+          fErrors(0),
+          fParameterCount(0),
+          fHasWork(false),
+          fReadsParameters(false),
+          fAudioIns(0),
+          fAudioOuts(0),
+          fInputBuffers(),
+          fOutputBuffers(),
+          fMidiEventTotal(0) {}
+
+    virtual ~PluginTest() {}
+
+    bool test()
+    {
+        {
+            const ScopedTiming st(fTimings[kCallInstantiate]);
+
+            if (! instantiate())
+            {
+                std::printf("%s: failed to instantiate\n", fFormat);
+                return false;
+            }
+        }
+
+        fParameterCount = getParameterCount();
+        allocateBuffers();
+
+        {
+            const ScopedTiming st(fTimings[kCallActivate]);
+            activate();
+        }
+
+        for (uint32_t i=0; i < fOptions.iterations; ++i)
+        {
+            for (uint32_t j=0; j < fOptions.parameterChanges && fParameterCount != 0; ++j)
+            {
+                const float value = static_cast<float>((i + j) % 101) / 100.0f;
+                const ScopedTiming st(fTimings[kCallSetParameter]);
+                setParameter((i * fOptions.parameterChanges + j) % fParameterCount, value);
+            }
+
+            fillInputs(i);
+            prepareMidi(i);
+
+            {
+                const ScopedTiming st(fTimings[kCallRun]);
+                process();
+            }
+
+            if (fHasWork)
+            {
+                const ScopedTiming st(fTimings[kCallWork]);
+                runWork();
+            }
+
+            checkOutputs(i);
+        }
+
+        checkSaveRestore();
+
+        {
+            const ScopedTiming st(fTimings[kCallDeactivate]);
+            deactivate();
+        }
+
+        {
+            const ScopedTiming st(fTimings[kCallCleanup]);
+            cleanup();
+        }
+
+        printReport();
+        return fErrors == 0;
+    }
+
+protected:
+    const char* const  fFormat;
+    const HostOptions& fOptions;
+    uint32_t fErrors;
+    uint32_t fParameterCount;
+    bool fHasWork;
+    bool fReadsParameters; // getParameter() asks the plugin, instead of reading host-side control ports
+    std::string fName;
+
+    uint32_t fAudioIns;
+    uint32_t fAudioOuts;
+    std::vector<float*> fInputBuffers;
+    std::vector<float*> fOutputBuffers;
+
+    virtual bool instantiate() = 0;
+    virtual void activate() = 0;
+    virtual void process() = 0;
+    virtual void deactivate() = 0;
+    virtual void cleanup() = 0;
+
+    // parameter values are normalized [0, 1] when setting, raw when reading back
+    virtual uint32_t getParameterCount() const = 0;
+    virtual float getParameter(uint32_t index) const = 0;
+    virtual void setParameter(uint32_t index, float normalized) = 0;
+
+    // opaque plugin state besides parameter values, might be empty
+    virtual bool saveState(std::string& state) = 0;
+    virtual bool restoreState(const std::string& state) = 0;
+
+    // called after each run, for ABIs with deferred work
+    virtual void runWork() {}
+
+    // prepare MIDI events for the next run, sorted by frame, returns how many the plugin receives
+    virtual uint32_t setMidiEvents(const HostMidiEvent* events, uint32_t count)
+    {
+        // unused
+        (void)events;
+        (void)count;
+        return 0;
+    }
+
+    void error(const char* const msg, const uint32_t index = 0)
+    {
+        if (++fErrors <= 10)
+            std::printf("%s: %s (%u)\n", fFormat, msg, index);
+    }
+
+private:
+    CallTiming fTimings[kCallCount];
+    std::vector<float> fBufferData;
+
+    HostMidiEvent fMidiEvents[kMaxMidiEvents];
+    uint64_t fMidiEventTotal;
+
+    void allocateBuffers()
+    {
+        const uint32_t frames = fOptions.bufferSize;
+
+        fBufferData.assign((fAudioIns + fAudioOuts) * frames, 0.0f);
+
+        for (uint32_t i=0; i < fAudioIns; ++i)
+            fInputBuffers.push_back(&fBufferData[i * frames]);
+        for (uint32_t i=0; i < fAudioOuts; ++i)
+            fOutputBuffers.push_back(&fBufferData[(fAudioIns + i) * frames]);
+
+        connectBuffers();
+    }
+
+    // audio buffers are ready, connect them to the plugin
+    virtual void connectBuffers() = 0;
+
+    void fillInputs(const uint32_t iteration)
+    {
+        const uint32_t frames = fOptions.bufferSize;
+        const double   step   = 2.0 * M_PI * 440.0 / fOptions.sampleRate;
+
+        for (uint32_t c=0; c < fAudioIns; ++c)
+        {
+            float* const buffer = fInputBuffers[c];
+            const double offset = static_cast<double>(iteration) * frames;
+
+            for (uint32_t i=0; i < frames; ++i)
+                buffer[i] = 0.5f * static_cast<float>(std::sin(step * (offset + i) + c));
+        }
+
+        // poison outputs, so plugins not writing them are noticed
+        for (uint32_t c=0; c < fAudioOuts; ++c)
+            std::fill(fOutputBuffers[c], fOutputBuffers[c] + frames, NAN);
+    }
+
+    void prepareMidi(const uint32_t iteration)
+    {
+        const uint32_t frames = fOptions.bufferSize;
+        uint32_t count = 0;
+
+        if (fOptions.midiEvents < 0)
+        {
+            // a note on at the block start, and its note off at the end of a later block
+            if (iteration % kMidiNoteInterval == 0)
+                setMidiEvent(count++, 0, 0x90, 60);
+            if (iteration % kMidiNoteInterval == kMidiNoteLength)
+                setMidiEvent(count++, frames - 1, 0x80, 60);
+        }
+        else
+        {
+            // evenly spread, alternating note on and off
+            count = std::min(static_cast<uint32_t>(fOptions.midiEvents), kMaxMidiEvents);
+
+            for (uint32_t i=0; i < count; ++i)
+                setMidiEvent(i, i * frames / count, (i & 1) ? 0x80 : 0x90, static_cast<uint8_t>(48 + (i/2) % 24));
+        }
+
+        fMidiEventTotal += setMidiEvents(fMidiEvents, count);
+    }
+
+    void setMidiEvent(const uint32_t index, const uint32_t frame, const uint8_t status, const uint8_t note)
+    {
+        HostMidiEvent& event(fMidiEvents[index]);
+        event.frame   = frame;
+        event.data[0] = status;
+        event.data[1] = note;
+        event.data[2] = 100;
+    }
+
+    void checkOutputs(const uint32_t iteration)
+    {
+        const uint32_t frames = fOptions.bufferSize;
+
+        for (uint32_t c=0; c < fAudioOuts; ++c)
+        {
+            const float* const buffer = fOutputBuffers[c];
+
+            for (uint32_t i=0; i < frames; ++i)
+            {
+                if (std::isfinite(buffer[i]))
+                    continue;
+
+                error("non-finite output sample in block", iteration);
+                break;
+            }
+        }
+    }
+
+    void checkSaveRestore()
+    {
+        const uint32_t parameterCount = fParameterCount;
+
+        std::vector<float> values(parameterCount);
+        std::string state, state2;
+
+        {
+            const ScopedTiming st(fTimings[kCallSave]);
+
+            for (uint32_t i=0; i < parameterCount; ++i)
+                values[i] = getParameter(i);
+
+            if (! saveState(state))
+                error("failed to save state");
+        }
+
+        // change everything, so restore has something to do
+        for (uint32_t i=0; i < parameterCount; ++i)
+            setParameter(i, values[i] == getParameterMin(i) ? 1.0f : 0.0f);
+
+        {
+            const ScopedTiming st(fTimings[kCallRestore]);
+
+            for (uint32_t i=0; i < parameterCount; ++i)
+                setParameterRaw(i, values[i]);
+
+            if (! restoreState(state))
+                error("failed to restore state");
+        }
+
+        // control port values are owned by the host, reading them back would always match
+        for (uint32_t i=0; i < parameterCount && fReadsParameters; ++i)
+        {
+            if (std::fabs(getParameter(i) - values[i]) > 1e-5f)
+                error("parameter value differs after restore", i);
+        }
+
+        if (! saveState(state2) || state != state2)
+            error("state differs after restore");
+    }
+
+    virtual float getParameterMin(uint32_t index) const = 0;
+    virtual void setParameterRaw(uint32_t index, float value) = 0;
+
+    void printReport() const
+    {
+        const uint32_t frames = fOptions.bufferSize;
+
+        if (fOptions.benchmark)
+        {
+            const CallTiming& run(fTimings[kCallRun]);
+            const CallTiming& set(fTimings[kCallSetParameter]);
+
+            std::printf("%-6s %5u frames %4u params/block %6.1f midi/block %12.1f ns/block (min %.1f) %8.1f ns/param %s\n",
+                        fFormat, frames, fParameterCount != 0 ? fOptions.parameterChanges : 0,
+                        static_cast<double>(fMidiEventTotal) / static_cast<double>(fOptions.iterations),
+                        run.count != 0 ? static_cast<double>(run.total) / static_cast<double>(run.count) : 0.0,
+                        static_cast<double>(run.min),
+                        set.count != 0 ? static_cast<double>(set.total) / static_cast<double>(set.count) : 0.0,
+                        fErrors == 0 ? "ok" : "FAILED");
+            return;
+        }
+
+        std::printf("%s: %s, %u ins, %u outs, %u parameters, %u x %u frames at %g Hz\n",
+                    fFormat, fName.c_str(), fAudioIns, fAudioOuts, fParameterCount,
+                    fOptions.iterations, frames, fOptions.sampleRate);
+        std::printf("  %-14s %8s %12s %12s %12s\n", "call", "count", "min (us)", "avg (us)", "max (us)");
+
+        for (uint32_t i=0; i < kCallCount; ++i)
+        {
+            const CallTiming& timing(fTimings[i]);
+
+            if (timing.count == 0)
+                continue;
+
+            std::printf("  %-14s %8llu %12.3f %12.3f %12.3f\n", kCallNames[i],
+                        static_cast<unsigned long long>(timing.count),
+                        static_cast<double>(timing.min) / 1000.0,
+                        static_cast<double>(timing.total) / 1000.0 / static_cast<double>(timing.count),
+                        static_cast<double>(timing.max) / 1000.0);
+        }
+
+        const CallTiming& run(fTimings[kCallRun]);
+
+        if (run.count != 0)
+            std::printf("  run cost: %.2f ns/frame, %.3f%% of real-time\n",
+                        static_cast<double>(run.total) / static_cast<double>(run.count * frames),
+                        static_cast<double>(run.total) / 1e7 * fOptions.sampleRate / static_cast<double>(run.count * frames));
+
+        if (! fReadsParameters && fParameterCount != 0)
+            std::printf("  parameter restore: not checked, values are host-side control ports\n");
+
+        std::printf("  result: %s\n\n", fErrors == 0 ? "ok" : "FAILED");
+    }
+};
+
+// -----------------------------------------------------------------------
+// LV2
+
+struct Lv2Port {
+    enum Type { kAudio, kControl, kAtom } type;
+    bool input;
+    uint32_t index;
+    float def, min, max;
+};
+
+// Reads the ports of a DPF generated plugin TTL, which has a known layout of one property per line.
+static bool parseLv2Ttl(const std::string& filename, std::string& uri, std::vector<Lv2Port>& ports)
+{
+    std::ifstream file(filename.c_str());
+
+    if (! file.good())
+        return false;
+
+    std::string line;
+
+    while (std::getline(file, line))
+    {
+        const std::string::size_type start = line.find_first_not_of(" \t");
+
+        if (start == std::string::npos)
+            continue;
+
+        const char* const str = line.c_str() + start;
+
+        if (uri.empty() && str[0] == '<' && line.find('>') != std::string::npos)
+        {
+            uri = line.substr(start + 1, line.find('>') - start - 1);
+            continue;
+        }
+
+        if (std::strncmp(str, "a lv2:InputPort,", 16) == 0 || std::strncmp(str, "a lv2:OutputPort,", 17) == 0)
+        {
+            Lv2Port port;
+            port.input = str[6] == 'I';
+            port.index = 0;
+            port.def   = 0.0f;
+            port.min   = 0.0f;
+            port.max   = 1.0f;
+
+            if (std::strstr(str, "lv2:ControlPort") != nullptr)
+                port.type = Lv2Port::kControl;
+            else if (std::strstr(str, "atom:AtomPort") != nullptr)
+                port.type = Lv2Port::kAtom;
+            else
+                port.type = Lv2Port::kAudio;
+
+            ports.push_back(port);
+            continue;
+        }
+
+        if (ports.empty())
+            continue;
+
+        Lv2Port& port(ports.back());
+
+        /**/ if (std::strncmp(str, "lv2:index ", 10) == 0)
+            port.index = static_cast<uint32_t>(std::atoi(str + 10));
+        else if (std::strncmp(str, "lv2:default ", 12) == 0)
+            port.def = static_cast<float>(std::atof(str + 12));
+        else if (std::strncmp(str, "lv2:minimum ", 12) == 0)
+            port.min = static_cast<float>(std::atof(str + 12));
+        else if (std::strncmp(str, "lv2:maximum ", 12) == 0)
+            port.max = static_cast<float>(std::atof(str + 12));
+    }
+
+    return !uri.empty();
+}
+
+class Lv2Test : public PluginTest
+{
+public:
+    Lv2Test(void* const lib, const std::string& filename, const HostOptions& options)
+        : PluginTest("LV2", options),
+          fLib(lib),
+          fFilename(filename),
+          fDescriptor(nullptr),
+          fHandle(nullptr),
+          fStateInterface(nullptr),
+          fWorkerInterface(nullptr),
+          fEventsIn(nullptr),
+          fEventsOut(nullptr),
+          fWorkSize(0),
+          fResponseSize(0)
+    {
+        fUridMap.handle = this;
+        fUridMap.map    = _map;
+        fUridUnmap.handle = this;
+        fUridUnmap.unmap  = _unmap;
+        fWorkSchedule.handle = this;
+        fWorkSchedule.schedule_work = _scheduleWork;
+
+        fBufferSizeValue = static_cast<int>(options.bufferSize);
+
+        const LV2_URID atomInt = map(LV2_ATOM__Int);
+
+        const LV2_Options_Option opts[] = {
+            { LV2_OPTIONS_INSTANCE, 0, map(LV2_BUF_SIZE__nominalBlockLength), sizeof(int), atomInt, &fBufferSizeValue },
+            { LV2_OPTIONS_INSTANCE, 0, map(LV2_BUF_SIZE__maxBlockLength),     sizeof(int), atomInt, &fBufferSizeValue },
+            { LV2_OPTIONS_INSTANCE, 0, 0, 0, 0, nullptr }
+        };
+        std::memcpy(fOptionsList, opts, sizeof(opts));
+
+        fFeatureUridMap.URI      = LV2_URID__map;
+        fFeatureUridMap.data     = &fUridMap;
+        fFeatureUridUnmap.URI    = LV2_URID__unmap;
+        fFeatureUridUnmap.data   = &fUridUnmap;
+        fFeatureOptions.URI      = LV2_OPTIONS__options;
+        fFeatureOptions.data     = fOptionsList;
+        fFeatureWorker.URI       = LV2_WORKER__schedule;
+        fFeatureWorker.data      = &fWorkSchedule;
+        fFeatureBoundedBlock.URI  = LV2_BUF_SIZE__boundedBlockLength;
+        fFeatureBoundedBlock.data = nullptr;
+
+        fFeatures[0] = &fFeatureUridMap;
+        fFeatures[1] = &fFeatureUridUnmap;
+        fFeatures[2] = &fFeatureOptions;
+        fFeatures[3] = &fFeatureWorker;
+        fFeatures[4] = &fFeatureBoundedBlock;
+        fFeatures[5] = nullptr;
+
+        fURIDs.atomSequence = map(LV2_ATOM__Sequence);
+        fURIDs.atomChunk    = map(LV2_ATOM__Chunk);
+        fURIDs.midiEvent    = map(LV2_MIDI__MidiEvent);
+    }
+
+protected:
+    bool instantiate() override
+    {
+        typedef const LV2_Descriptor* (*DescriptorFunc)(uint32_t);
+        const DescriptorFunc descFn = (DescriptorFunc)dlsym(fLib, "lv2_descriptor");
+
+        if (descFn == nullptr || ! loadPorts())
+            return false;
+
+        for (uint32_t i=0; (fDescriptor = descFn(i)) != nullptr; ++i)
+        {
+            if (fName == fDescriptor->URI)
+                break;
+        }
+
+        if (fDescriptor == nullptr)
+            return false;
+
+        fHandle = fDescriptor->instantiate(fDescriptor, fOptions.sampleRate, fBundlePath.c_str(), fFeatures);
+
+        if (fHandle == nullptr)
+            return false;
+
+        if (fDescriptor->extension_data != nullptr)
+        {
+            fStateInterface  = (const LV2_State_Interface*)fDescriptor->extension_data(LV2_STATE__interface);
+            fWorkerInterface = (const LV2_Worker_Interface*)fDescriptor->extension_data(LV2_WORKER__interface);
+            fHasWork = fWorkerInterface != nullptr;
+        }
+
+        return true;
+    }
+
+    void connectBuffers() override
+    {
+        uint32_t audioIn = 0, audioOut = 0;
+
+        for (std::vector<Lv2Port>::iterator it=fPorts.begin(), end=fPorts.end(); it != end; ++it)
+        {
+            Lv2Port& port(*it);
+            void* data = nullptr;
+
+            switch (port.type)
+            {
+            case Lv2Port::kAudio:
+                data = port.input ? fInputBuffers[audioIn++] : fOutputBuffers[audioOut++];
+                break;
+            case Lv2Port::kControl:
+                data = &fControlValues[port.index];
+                break;
+            case Lv2Port::kAtom:
+                data = port.input ? (void*)fEventsIn : (void*)fEventsOut;
+                break;
+            }
+
+            fDescriptor->connect_port(fHandle, port.index, data);
+        }
+    }
+
+    void activate() override
+    {
+        if (fDescriptor->activate != nullptr)
+            fDescriptor->activate(fHandle);
+    }
+
+    uint32_t setMidiEvents(const HostMidiEvent* const events, const uint32_t count) override
+    {
+        if (fEventsIn != nullptr)
+        {
+            lv2_atom_sequence_clear(fEventsIn);
+
+            for (uint32_t i=0; i < count; ++i)
+                appendMidiEvent(events[i]);
+        }
+
+        if (fEventsOut != nullptr)
+        {
+            fEventsOut->atom.size = kEventBufferSize - sizeof(LV2_Atom);
+            fEventsOut->atom.type = fURIDs.atomChunk;
+        }
+
+        return fEventsIn != nullptr ? count : 0;
+    }
+
+    void process() override
+    {
+        fDescriptor->run(fHandle, fOptions.bufferSize);
+    }
+
+    void runWork() override
+    {
+        for (uint32_t offset=0; offset < fWorkSize;)
+        {
+            uint32_t size;
+            std::memcpy(&size, fWorkData + offset, sizeof(uint32_t));
+            fWorkerInterface->work(fHandle, _respond, this, size, fWorkData + offset + sizeof(uint32_t));
+            offset += sizeof(uint32_t) + size;
+        }
+
+        for (uint32_t offset=0; offset < fResponseSize;)
+        {
+            uint32_t size;
+            std::memcpy(&size, fResponseData + offset, sizeof(uint32_t));
+            fWorkerInterface->work_response(fHandle, size, fResponseData + offset + sizeof(uint32_t));
+            offset += sizeof(uint32_t) + size;
+        }
+
+        if (fWorkerInterface->end_run != nullptr)
+            fWorkerInterface->end_run(fHandle);
+
+        fWorkSize = fResponseSize = 0;
+    }
+
+    void deactivate() override
+    {
+        if (fDescriptor->deactivate != nullptr)
+            fDescriptor->deactivate(fHandle);
+    }
+
+    void cleanup() override
+    {
+        fDescriptor->cleanup(fHandle);
+        fHandle = nullptr;
+    }
+
+    uint32_t getParameterCount() const override
+    {
+        return static_cast<uint32_t>(fInputControls.size());
+    }
+
+    float getParameter(const uint32_t index) const override
+    {
+        return fControlValues[fInputControls[index]->index];
+    }
+
+    void setParameter(const uint32_t index, const float normalized) override
+    {
+        const Lv2Port& port(*fInputControls[index]);
+        fControlValues[port.index] = port.min + normalized * (port.max - port.min);
+    }
+
+    float getParameterMin(const uint32_t index) const override
+    {
+        return fInputControls[index]->min;
+    }
+
+    void setParameterRaw(const uint32_t index, const float value) override
+    {
+        fControlValues[fInputControls[index]->index] = value;
+    }
+
+    bool saveState(std::string& state) override
+    {
+        fStateValues.clear();
+        state.clear();
+
+        if (fStateInterface == nullptr)
+            return true;
+
+        if (fStateInterface->save(fHandle, _store, this, LV2_STATE_IS_POD|LV2_STATE_IS_PORTABLE, fFeatures) != LV2_STATE_SUCCESS)
+            return false;
+
+        for (StateMap::const_iterator it=fStateValues.begin(), end=fStateValues.end(); it != end; ++it)
+        {
+            state += fURIs[it->first - 1];
+            state += '\0';
+            state += it->second.data;
+            state += '\0';
+        }
+
+        return true;
+    }
+
+    bool restoreState(const std::string&) override
+    {
+        // the values stored by the last save are restored as-is
+        if (fStateInterface == nullptr)
+            return true;
+
+        return fStateInterface->restore(fHandle, _retrieve, this, LV2_STATE_IS_POD|LV2_STATE_IS_PORTABLE, fFeatures) == LV2_STATE_SUCCESS;
+    }
+
+private:
+    void* const fLib;
+    const std::string fFilename;
+    std::string fBundlePath;
+
+    const LV2_Descriptor* fDescriptor;
+    LV2_Handle fHandle;
+    const LV2_State_Interface*  fStateInterface;
+    const LV2_Worker_Interface* fWorkerInterface;
+
+    std::vector<Lv2Port> fPorts;
+    std::vector<const Lv2Port*> fInputControls;
+    std::vector<float> fControlValues;
+
+    LV2_Atom_Sequence* fEventsIn;
+    LV2_Atom_Sequence* fEventsOut;
+    uint64_t fEventsInData[kEventBufferSize/8];
+    uint64_t fEventsOutData[kEventBufferSize/8];
+
+    struct StateValue {
+        LV2_URID type;
+        std::string data;
+    };
+    typedef std::map<LV2_URID, StateValue> StateMap;
+
+    std::vector<std::string> fURIs;
+    StateMap fStateValues;
+
+    struct URIDs {
+        LV2_URID atomSequence;
+        LV2_URID atomChunk;
+        LV2_URID midiEvent;
+    } fURIDs;
+
+    int fBufferSizeValue;
+
+    LV2_URID_Map        fUridMap;
+    LV2_URID_Unmap      fUridUnmap;
+    LV2_Worker_Schedule fWorkSchedule;
+    LV2_Options_Option  fOptionsList[3];
+    LV2_Feature fFeatureUridMap, fFeatureUridUnmap, fFeatureOptions, fFeatureWorker, fFeatureBoundedBlock;
+    const LV2_Feature* fFeatures[6];
+
+    // work requests and responses, each as size followed by data
+    uint8_t  fWorkData[kWorkBufferSize];
+    uint32_t fWorkSize;
+    uint8_t  fResponseData[kWorkBufferSize];
+    uint32_t fResponseSize;
+
+    bool loadPorts()
+    {
+        const std::string::size_type slash = fFilename.rfind('/');
+        const std::string dir(slash != std::string::npos ? fFilename.substr(0, slash) : std::string("."));
+        std::string basename(slash != std::string::npos ? fFilename.substr(slash + 1) : fFilename);
+        basename = basename.substr(0, basename.rfind('.'));
+
+        fBundlePath = dir + "/";
+
+        // use the bundle TTL if present, otherwise ask the plugin to generate one
+        if (! parseLv2Ttl(fBundlePath + basename + ".ttl", fName, fPorts))
+        {
+            typedef void (*TtlFunc)(const char*);
+            const TtlFunc ttlFn = (TtlFunc)dlsym(fLib, "lv2_generate_ttl");
+
+            char tmpdir[] = "/tmp/dpf-test-host-XXXXXX";
+            char cwd[4096];
+
+            if (ttlFn == nullptr || mkdtemp(tmpdir) == nullptr || getcwd(cwd, sizeof(cwd)) == nullptr)
+                return false;
+
+            if (chdir(tmpdir) == 0)
+            {
+                // the generator reports progress on stdout, keep it out of our report
+                std::fflush(stdout);
+                const int out = dup(STDOUT_FILENO);
+                if (std::freopen("/dev/null", "w", stdout) != nullptr)
+                    ttlFn(basename.c_str());
+                std::fflush(stdout);
+                dup2(out, STDOUT_FILENO);
+                close(out);
+
+                parseLv2Ttl(basename + ".ttl", fName, fPorts);
+
+                std::remove((basename + ".ttl").c_str());
+                std::remove("manifest.ttl");
+                std::remove("presets.ttl");
+
+                if (chdir(cwd) != 0)
+                    return false;
+            }
+
+            rmdir(tmpdir);
+        }
+
+        if (fName.empty())
+            return false;
+
+        uint32_t maxIndex = 0;
+
+        for (std::vector<Lv2Port>::const_iterator it=fPorts.begin(), end=fPorts.end(); it != end; ++it)
+        {
+            if (it->index > maxIndex)
+                maxIndex = it->index;
+        }
+
+        fControlValues.assign(maxIndex + 1, 0.0f);
+
+        for (std::vector<Lv2Port>::const_iterator it=fPorts.begin(), end=fPorts.end(); it != end; ++it)
+        {
+            const Lv2Port& port(*it);
+
+            switch (port.type)
+            {
+            case Lv2Port::kAudio:
+                if (port.input)
+                    ++fAudioIns;
+                else
+                    ++fAudioOuts;
+                break;
+            case Lv2Port::kControl:
+                fControlValues[port.index] = port.def;
+                if (port.input)
+                    fInputControls.push_back(&port);
+                break;
+            case Lv2Port::kAtom:
+                if (port.input)
+                    fEventsIn = (LV2_Atom_Sequence*)fEventsInData;
+                else
+                    fEventsOut = (LV2_Atom_Sequence*)fEventsOutData;
+                break;
+            }
+        }
+
+        if (fEventsIn != nullptr)
+        {
+            fEventsIn->atom.size = sizeof(LV2_Atom_Sequence_Body);
+            fEventsIn->atom.type = fURIDs.atomSequence;
+            fEventsIn->body.unit = 0;
+            fEventsIn->body.pad  = 0;
+        }
+
+        return true;
+    }
+
+    void appendMidiEvent(const HostMidiEvent& hostEvent)
+    {
+        struct {
+            LV2_Atom_Event event;
+            uint8_t data[3];
+        } midi;
+
+        midi.event.time.frames = hostEvent.frame;
+        midi.event.body.size   = 3;
+        midi.event.body.type   = fURIDs.midiEvent;
+        std::memcpy(midi.data, hostEvent.data, 3);
+
+        lv2_atom_sequence_append_event(fEventsIn, kEventBufferSize - sizeof(LV2_Atom), &midi.event);
+    }
+
+    LV2_URID map(const char* const uri)
+    {
+        for (std::size_t i=0; i < fURIs.size(); ++i)
+        {
+            if (fURIs[i] == uri)
+                return static_cast<LV2_URID>(i + 1);
+        }
+
+        fURIs.push_back(uri);
+        return static_cast<LV2_URID>(fURIs.size());
+    }
+
+    static LV2_URID _map(LV2_URID_Map_Handle handle, const char* uri)
+    {
+        return ((Lv2Test*)handle)->map(uri);
+    }
+
+    static const char* _unmap(LV2_URID_Unmap_Handle handle, LV2_URID urid)
+    {
+        Lv2Test* const self = (Lv2Test*)handle;
+        return (urid != 0 && urid <= self->fURIs.size()) ? self->fURIs[urid - 1].c_str() : nullptr;
+    }
+
+    static LV2_Worker_Status _queue(uint8_t* const buffer, uint32_t& used, const uint32_t size, const void* const data)
+    {
+        if (used + sizeof(uint32_t) + size > kWorkBufferSize)
+            return LV2_WORKER_ERR_NO_SPACE;
+
+        std::memcpy(buffer + used, &size, sizeof(uint32_t));
+        std::memcpy(buffer + used + sizeof(uint32_t), data, size);
+        used += sizeof(uint32_t) + size;
+        return LV2_WORKER_SUCCESS;
+    }
+
+    static LV2_Worker_Status _scheduleWork(LV2_Worker_Schedule_Handle handle, uint32_t size, const void* data)
+    {
+        Lv2Test* const self = (Lv2Test*)handle;
+        return _queue(self->fWorkData, self->fWorkSize, size, data);
+    }
+
+    static LV2_Worker_Status _respond(LV2_Worker_Respond_Handle handle, uint32_t size, const void* data)
+    {
+        Lv2Test* const self = (Lv2Test*)handle;
+        return _queue(self->fResponseData, self->fResponseSize, size, data);
+    }
+
+    static LV2_State_Status _store(LV2_State_Handle handle, uint32_t key, const void* value, size_t size, uint32_t type, uint32_t)
+    {
+        Lv2Test* const self = (Lv2Test*)handle;
+        StateValue& stateValue(self->fStateValues[key]);
+        stateValue.type = type;
+        stateValue.data.assign((const char*)value, size);
+        return LV2_STATE_SUCCESS;
+    }
+
+    static const void* _retrieve(LV2_State_Handle handle, uint32_t key, size_t* size, uint32_t* type, uint32_t* flags)
+    {
+        Lv2Test* const self = (Lv2Test*)handle;
+        const StateMap::const_iterator it = self->fStateValues.find(key);
+
+        if (it == self->fStateValues.end())
+            return nullptr;
+
+        if (size != nullptr)
+            *size = it->second.data.size();
+        if (type != nullptr)
+            *type = it->second.type;
+        if (flags != nullptr)
+            *flags = LV2_STATE_IS_POD|LV2_STATE_IS_PORTABLE;
+
+        return it->second.data.data();
+    }
+};
+
+// -----------------------------------------------------------------------
+// VST
+
+class VstTest : public PluginTest
+{
+public:
+    VstTest(void* const lib, const HostOptions& options)
+        : PluginTest("VST", options),
+          fLib(lib),
+          fEffect(nullptr),
+          fEventCount(0)
+    {
+        std::memset(&fTimeInfo, 0, sizeof(fTimeInfo));
+        fTimeInfo.sampleRate         = options.sampleRate;
+        fTimeInfo.tempo              = 120.0;
+        fTimeInfo.timeSigNumerator   = 4;
+        fTimeInfo.timeSigDenominator = 4;
+        fTimeInfo.flags              = kVstTransportPlaying|kVstPpqPosValid|kVstTempoValid|kVstBarsValid|kVstTimeSigValid;
+
+        fReadsParameters = true;
+
+        std::memset(fMidiEvents, 0, sizeof(fMidiEvents));
+        std::memset(&fEvents, 0, sizeof(fEvents));
+    }
+
+protected:
+    bool instantiate() override
+    {
+        typedef AEffect* (*MainFunc)(audioMasterCallback);
+        MainFunc mainFn = (MainFunc)dlsym(fLib, "VSTPluginMain");
+
+        // DPF exports the VST entry point as "main" on Linux
+        if (mainFn == nullptr)
+            mainFn = (MainFunc)dlsym(fLib, "main");
+        if (mainFn == nullptr)
+            return false;
+
+        sCurrent = this;
+        fEffect  = mainFn(_hostCallback);
+
+        if (fEffect == nullptr || fEffect->magic != kEffectMagic)
+            return false;
+
+        fEffect->dispatcher(fEffect, effOpen, 0, 0, nullptr, 0.0f);
+        fEffect->dispatcher(fEffect, effSetSampleRate, 0, 0, nullptr, static_cast<float>(fOptions.sampleRate));
+        fEffect->dispatcher(fEffect, effSetBlockSize, 0, fOptions.bufferSize, nullptr, 0.0f);
+
+        char name[256] = { '\0' };
+        fEffect->dispatcher(fEffect, effGetEffectName, 0, 0, name, 0.0f);
+        fName = name;
+
+        fAudioIns  = static_cast<uint32_t>(fEffect->numInputs);
+        fAudioOuts = static_cast<uint32_t>(fEffect->numOutputs);
+        return true;
+    }
+
+    void connectBuffers() override {}
+
+    void activate() override
+    {
+        fEffect->dispatcher(fEffect, effMainsChanged, 0, 1, nullptr, 0.0f);
+    }
+
+    uint32_t setMidiEvents(const HostMidiEvent* const events, const uint32_t count) override
+    {
+        for (uint32_t i=0; i < count; ++i)
+        {
+            VstMidiEvent& event(fMidiEvents[i]);
+            event.type        = kVstMidiType;
+            event.byteSize    = sizeof(VstMidiEvent);
+            event.deltaFrames = static_cast<int>(events[i].frame);
+            std::memcpy(event.midiData, events[i].data, 3);
+
+            fEvents.events[i] = (VstEvent*)&event;
+        }
+
+        fEvents.numEvents = fEventCount = static_cast<int>(count);
+        return count;
+    }
+
+    void process() override
+    {
+        if (fEventCount != 0)
+            fEffect->dispatcher(fEffect, effProcessEvents, 0, 0, &fEvents, 0.0f);
+
+        fEffect->processReplacing(fEffect,
+                                  fInputBuffers.empty() ? nullptr : &fInputBuffers[0],
+                                  fOutputBuffers.empty() ? nullptr : &fOutputBuffers[0],
+                                  static_cast<int>(fOptions.bufferSize));
+
+        fTimeInfo.samplePos += fOptions.bufferSize;
+        fTimeInfo.ppqPos = fTimeInfo.samplePos / fOptions.sampleRate * fTimeInfo.tempo / 60.0;
+        fTimeInfo.barStartPos = std::floor(fTimeInfo.ppqPos / 4.0) * 4.0;
+    }
+
+    void deactivate() override
+    {
+        fEffect->dispatcher(fEffect, effMainsChanged, 0, 0, nullptr, 0.0f);
+    }
+
+    void cleanup() override
+    {
+        // the plugin deletes the effect on close
+        fEffect->dispatcher(fEffect, effClose, 0, 0, nullptr, 0.0f);
+        fEffect  = nullptr;
+        sCurrent = nullptr;
+    }
+
+    uint32_t getParameterCount() const override
+    {
+        return static_cast<uint32_t>(fEffect->numParams);
+    }
+
+    float getParameter(const uint32_t index) const override
+    {
+        return fEffect->getParameter(fEffect, static_cast<int>(index));
+    }
+
+    void setParameter(const uint32_t index, const float normalized) override
+    {
+        fEffect->setParameter(fEffect, static_cast<int>(index), normalized);
+    }
+
+    float getParameterMin(uint32_t) const override
+    {
+        return 0.0f;
+    }
+
+    void setParameterRaw(const uint32_t index, const float value) override
+    {
+        fEffect->setParameter(fEffect, static_cast<int>(index), value);
+    }
+
+    bool saveState(std::string& state) override
+    {
+        state.clear();
+
+        if ((fEffect->flags & effFlagsProgramChunks) == 0)
+            return true;
+
+        void* chunk = nullptr;
+        const intptr_t size = fEffect->dispatcher(fEffect, effGetChunk, 0, 0, &chunk, 0.0f);
+
+        if (size <= 0 || chunk == nullptr)
+            return false;
+
+        state.assign((const char*)chunk, static_cast<std::size_t>(size));
+        return true;
+    }
+
+    bool restoreState(const std::string& state) override
+    {
+        if (state.empty())
+            return true;
+
+        std::vector<char> chunk(state.begin(), state.end());
+        return fEffect->dispatcher(fEffect, effSetChunk, 0, static_cast<intptr_t>(chunk.size()), &chunk[0], 0.0f) != 0;
+    }
+
+private:
+    void* const fLib;
+    AEffect* fEffect;
+    VstTimeInfo fTimeInfo;
+
+    VstMidiEvent fMidiEvents[kMaxMidiEvents];
+    int fEventCount;
+
+    // same layout as VstEvents, with room for more than 2 events
+    struct {
+        int numEvents;
+        void* reserved;
+        VstEvent* events[kMaxMidiEvents];
+    } fEvents;
+
+    static VstTest* sCurrent;
+
+    static intptr_t _hostCallback(AEffect*, int32_t opcode, int32_t, intptr_t, void*, float)
+    {
+        switch (opcode)
+        {
+        case audioMasterVersion:
+            return 2400;
+        case audioMasterGetSampleRate:
+            return static_cast<intptr_t>(sCurrent->fOptions.sampleRate);
+        case audioMasterGetBlockSize:
+            return static_cast<intptr_t>(sCurrent->fOptions.bufferSize);
+        case audioMasterGetTime:
+            return (intptr_t)&sCurrent->fTimeInfo;
+        default:
+            return 0;
+        }
+    }
+};
+
+VstTest* VstTest::sCurrent = nullptr;
+
+// -----------------------------------------------------------------------
+// LADSPA and DSSI
+
+static float getLadspaDefault(const LADSPA_PortRangeHint& hint)
+{
+    const LADSPA_PortRangeHintDescriptor hints = hint.HintDescriptor;
+    const float low  = LADSPA_IS_HINT_BOUNDED_BELOW(hints) ? hint.LowerBound : 0.0f;
+    const float high = LADSPA_IS_HINT_BOUNDED_ABOVE(hints) ? hint.UpperBound : 1.0f;
+
+    switch (hints & LADSPA_HINT_DEFAULT_MASK)
+    {
+    case LADSPA_HINT_DEFAULT_MINIMUM: return low;
+    case LADSPA_HINT_DEFAULT_LOW:     return low * 0.75f + high * 0.25f;
+    case LADSPA_HINT_DEFAULT_MIDDLE:  return low * 0.5f + high * 0.5f;
+    case LADSPA_HINT_DEFAULT_HIGH:    return low * 0.25f + high * 0.75f;
+    case LADSPA_HINT_DEFAULT_MAXIMUM: return high;
+    case LADSPA_HINT_DEFAULT_0:       return 0.0f;
+    case LADSPA_HINT_DEFAULT_1:       return 1.0f;
+    case LADSPA_HINT_DEFAULT_100:     return 100.0f;
+    case LADSPA_HINT_DEFAULT_440:     return 440.0f;
+    default:                          return low;
+    }
+}
+
+class LadspaTest : public PluginTest
+{
+public:
+    LadspaTest(const LADSPA_Descriptor* const ladspa, const DSSI_Descriptor* const dssi, const HostOptions& options)
+        : PluginTest(dssi != nullptr ? "DSSI" : "LADSPA", options),
+          fLadspa(ladspa),
+          fDssi(dssi),
+          fHandle(nullptr),
+          fEventCount(0)
+    {
+        std::memset(fEvents, 0, sizeof(fEvents));
+    }
+
+protected:
+    bool instantiate() override
+    {
+        fName = fLadspa->Label;
+        fHandle = fLadspa->instantiate(fLadspa, static_cast<unsigned long>(fOptions.sampleRate));
+
+        if (fHandle == nullptr)
+            return false;
+
+        fControlValues.assign(fLadspa->PortCount, 0.0f);
+
+        for (unsigned long i=0; i < fLadspa->PortCount; ++i)
+        {
+            const LADSPA_PortDescriptor port = fLadspa->PortDescriptors[i];
+
+            if (LADSPA_IS_PORT_AUDIO(port))
+            {
+                if (LADSPA_IS_PORT_INPUT(port))
+                    ++fAudioIns;
+                else
+                    ++fAudioOuts;
+            }
+            else if (LADSPA_IS_PORT_INPUT(port))
+            {
+                fControlValues[i] = getLadspaDefault(fLadspa->PortRangeHints[i]);
+                fInputControls.push_back(static_cast<uint32_t>(i));
+            }
+        }
+
+        return true;
+    }
+
+    void connectBuffers() override
+    {
+        uint32_t audioIn = 0, audioOut = 0;
+
+        for (unsigned long i=0; i < fLadspa->PortCount; ++i)
+        {
+            const LADSPA_PortDescriptor port = fLadspa->PortDescriptors[i];
+
+            if (LADSPA_IS_PORT_AUDIO(port))
+                fLadspa->connect_port(fHandle, i, LADSPA_IS_PORT_INPUT(port) ? fInputBuffers[audioIn++]
+                                                                             : fOutputBuffers[audioOut++]);
+            else
+                fLadspa->connect_port(fHandle, i, &fControlValues[i]);
+        }
+    }
+
+    void activate() override
+    {
+        if (fLadspa->activate != nullptr)
+            fLadspa->activate(fHandle);
+    }
+
+    uint32_t setMidiEvents(const HostMidiEvent* const events, const uint32_t count) override
+    {
+        for (uint32_t i=0; i < count; ++i)
+        {
+            snd_seq_event_t& event(fEvents[i]);
+            event.type      = (events[i].data[0] & 0xf0) == 0x90 ? SND_SEQ_EVENT_NOTEON : SND_SEQ_EVENT_NOTEOFF;
+            event.time.tick = events[i].frame;
+            event.data.note.channel  = static_cast<unsigned char>(events[i].data[0] & 0x0f);
+            event.data.note.note     = events[i].data[1];
+            event.data.note.velocity = events[i].data[2];
+        }
+
+        fEventCount = count;
+        return fDssi != nullptr && fDssi->run_synth != nullptr ? count : 0;
+    }
+
+    void process() override
+    {
+        if (fDssi != nullptr && fDssi->run_synth != nullptr)
+            fDssi->run_synth(fHandle, fOptions.bufferSize, fEvents, fEventCount);
+        else
+            fLadspa->run(fHandle, fOptions.bufferSize);
+    }
+
+    void deactivate() override
+    {
+        if (fLadspa->deactivate != nullptr)
+            fLadspa->deactivate(fHandle);
+    }
+
+    void cleanup() override
+    {
+        fLadspa->cleanup(fHandle);
+        fHandle = nullptr;
+    }
+
+    uint32_t getParameterCount() const override
+    {
+        return static_cast<uint32_t>(fInputControls.size());
+    }
+
+    float getParameter(const uint32_t index) const override
+    {
+        return fControlValues[fInputControls[index]];
+    }
+
+    void setParameter(const uint32_t index, const float normalized) override
+    {
+        const LADSPA_PortRangeHint& hint(fLadspa->PortRangeHints[fInputControls[index]]);
+        const float low  = LADSPA_IS_HINT_BOUNDED_BELOW(hint.HintDescriptor) ? hint.LowerBound : 0.0f;
+        const float high = LADSPA_IS_HINT_BOUNDED_ABOVE(hint.HintDescriptor) ? hint.UpperBound : 1.0f;
+
+        fControlValues[fInputControls[index]] = low + normalized * (high - low);
+    }
+
+    float getParameterMin(const uint32_t index) const override
+    {
+        const LADSPA_PortRangeHint& hint(fLadspa->PortRangeHints[fInputControls[index]]);
+        return LADSPA_IS_HINT_BOUNDED_BELOW(hint.HintDescriptor) ? hint.LowerBound : 0.0f;
+    }
+
+    void setParameterRaw(const uint32_t index, const float value) override
+    {
+        fControlValues[fInputControls[index]] = value;
+    }
+
+    // LADSPA has no state, DSSI configure values are kept by the host and cannot be read back
+    bool saveState(std::string& state) override
+    {
+        state.clear();
+        return true;
+    }
+
+    bool restoreState(const std::string&) override
+    {
+        return true;
+    }
+
+private:
+    const LADSPA_Descriptor* const fLadspa;
+    const DSSI_Descriptor* const fDssi;
+    LADSPA_Handle fHandle;
+
+    std::vector<float> fControlValues;
+    std::vector<uint32_t> fInputControls;
+
+    snd_seq_event_t fEvents[kMaxMidiEvents];
+    unsigned long fEventCount;
+};
+
+// -----------------------------------------------------------------------
+
+static bool shouldTest(const HostOptions& options, const char* const format)
+{
+    return options.onlyFormat == nullptr || strcasecmp(options.onlyFormat, format) == 0;
+}
+
+int main(int argc, char* argv[])
+{
+    HostOptions options;
+    const char* filename = nullptr;
+
+    for (int i=1; i < argc; ++i)
+    {
+        const char* const arg = argv[i];
+
+        if (std::strcmp(arg, "-f") == 0 && i+1 < argc)
+            options.bufferSize = static_cast<uint32_t>(std::atoi(argv[++i]));
+        else if (std::strcmp(arg, "-r") == 0 && i+1 < argc)
+            options.sampleRate = std::atof(argv[++i]);
+        else if (std::strcmp(arg, "-n") == 0 && i+1 < argc)
+            options.iterations = static_cast<uint32_t>(std::atoi(argv[++i]));
+        else if (std::strcmp(arg, "-p") == 0 && i+1 < argc)
+            options.parameterChanges = static_cast<uint32_t>(std::atoi(argv[++i]));
+        else if (std::strcmp(arg, "-m") == 0 && i+1 < argc)
+            options.midiEvents = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "-t") == 0 && i+1 < argc)
+            options.onlyFormat = argv[++i];
+        else if (std::strcmp(arg, "-b") == 0)
+            options.benchmark = true;
+        else if (arg[0] != '-' && filename == nullptr)
+            filename = arg;
+        else
+            options.bufferSize = 0; // invalid, show usage
+    }
+
+    if (filename == nullptr || options.bufferSize == 0 || options.sampleRate <= 0.0)
+    {
+        std::printf("usage: %s [-f frames] [-r sample-rate] [-n iterations] [-p parameter-changes] [-m midi-events] [-t lv2|vst|ladspa|dssi] [-b] /path/to/plugin-DLL\n", argv[0]);
+        return 1;
+    }
+
+    void* const lib = dlopen(filename, RTLD_NOW|RTLD_LOCAL);
+
+    if (lib == nullptr)
+    {
+        std::printf("Failed to open plugin DLL, error was:\n%s\n", dlerror());
+        return 2;
+    }
+
+    uint32_t tested = 0, failed = 0;
+
+    if (dlsym(lib, "lv2_descriptor") != nullptr && shouldTest(options, "lv2"))
+    {
+        Lv2Test test(lib, filename, options);
+        ++tested;
+        if (! test.test())
+            ++failed;
+    }
+
+    if ((dlsym(lib, "VSTPluginMain") != nullptr || dlsym(lib, "main") != nullptr) && shouldTest(options, "vst"))
+    {
+        VstTest test(lib, options);
+        ++tested;
+        if (! test.test())
+            ++failed;
+    }
+
+    typedef const DSSI_Descriptor* (*DssiDescriptorFunc)(unsigned long);
+    typedef const LADSPA_Descriptor* (*LadspaDescriptorFunc)(unsigned long);
+
+    if (const DssiDescriptorFunc dssiFn = (DssiDescriptorFunc)dlsym(lib, "dssi_descriptor"))
+    {
+        const DSSI_Descriptor* const dssi = dssiFn(0);
+
+        if (dssi != nullptr && shouldTest(options, "dssi"))
+        {
+            LadspaTest test(dssi->LADSPA_Plugin, dssi, options);
+            ++tested;
+            if (! test.test())
+                ++failed;
+        }
+    }
+    else if (const LadspaDescriptorFunc ladspaFn = (LadspaDescriptorFunc)dlsym(lib, "ladspa_descriptor"))
+    {
+        const LADSPA_Descriptor* const ladspa = ladspaFn(0);
+
+        if (ladspa != nullptr && shouldTest(options, "ladspa"))
+        {
+            LadspaTest test(ladspa, nullptr, options);
+            ++tested;
+            if (! test.test())
+                ++failed;
+        }
+    }
+
+    dlclose(lib);
+
+    if (tested == 0)
+    {
+        std::printf("No supported plugin format found in %s\n", filename);
+        return 2;
+    }
+
+    return failed == 0 ? 0 : 3;
+}
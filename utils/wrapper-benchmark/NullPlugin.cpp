@@ -0,0 +1,156 @@
+/*
+ * DISTRHO Plugin Framework (DPF)
+ * Copyright (C) 2012-2016 Filipe Coelho <falktx@falktx.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with
+ * or without fee is hereby granted, provided that the above copyright notice and this
+ * permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+ * TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+ * NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include "DistrhoPlugin.hpp"
+
+// number of parameters and state keys, to measure how the wrappers scale with them
+#ifndef NULL_PLUGIN_PARAMETER_COUNT
+# define NULL_PLUGIN_PARAMETER_COUNT 16
+#endif
+
+#ifndef NULL_PLUGIN_STATE_COUNT
+# define NULL_PLUGIN_STATE_COUNT 4
+#endif
+
+START_NAMESPACE_DISTRHO
+
+// -----------------------------------------------------------------------------------------------------------
+
+/**
+  Plugin that copies its inputs to its outputs and does nothing else.
+  Used for measuring the cost of the plugin format wrappers alone.
+ */
+class NullPlugin : public Plugin
+{
+public:
+#if DISTRHO_PLUGIN_WANT_STATE
+    NullPlugin()
+        : Plugin(NULL_PLUGIN_PARAMETER_COUNT, 0, NULL_PLUGIN_STATE_COUNT)
+#else
+    NullPlugin()
+        : Plugin(NULL_PLUGIN_PARAMETER_COUNT, 0, 0)
+#endif
+    {
+        std::memset(fParameters, 0, sizeof(fParameters));
+    }
+
+protected:
+   /* --------------------------------------------------------------------------------------------------------
+    * Information */
+
+    const char* getLabel() const override
+    {
+        return "Null";
+    }
+
+    const char* getDescription() const override
+    {
+        return "Pass-through plugin for benchmarking the plugin format wrappers.";
+    }
+
+    const char* getMaker() const override
+    {
+        return "DISTRHO";
+    }
+
+    const char* getLicense() const override
+    {
+        return "ISC";
+    }
+
+    uint32_t getVersion() const override
+    {
+        return d_version(1, 0, 0);
+    }
+
+    int64_t getUniqueId() const override
+    {
+        return d_cconst('D', 'N', 'u', 'l');
+    }
+
+   /* --------------------------------------------------------------------------------------------------------
+    * Init */
+
+    void initParameter(uint32_t index, Parameter& parameter) override
+    {
+        parameter.hints      = kParameterIsAutomable;
+        parameter.name       = "Parameter " + String(index + 1);
+        parameter.symbol     = "param" + String(index + 1);
+        parameter.ranges.def = 0.0f;
+        parameter.ranges.min = 0.0f;
+        parameter.ranges.max = 1.0f;
+    }
+
+#if DISTRHO_PLUGIN_WANT_STATE
+    void initState(uint32_t index, String& stateKey, String& defaultStateValue) override
+    {
+        stateKey = "key" + String(index + 1);
+        defaultStateValue = "";
+    }
+#endif
+
+   /* --------------------------------------------------------------------------------------------------------
+    * Internal data */
+
+    float getParameterValue(uint32_t index) const override
+    {
+        return fParameters[index];
+    }
+
+    void setParameterValue(uint32_t index, float value) override
+    {
+        fParameters[index] = value;
+    }
+
+#if DISTRHO_PLUGIN_WANT_STATE
+    void setState(const char*, const char*) override {}
+#endif
+
+   /* --------------------------------------------------------------------------------------------------------
+    * Process */
+
+#if DISTRHO_PLUGIN_WANT_MIDI_INPUT
+    void run(const float** inputs, float** outputs, uint32_t frames, const MidiEvent*, uint32_t) override
+#else
+    void run(const float** inputs, float** outputs, uint32_t frames) override
+#endif
+    {
+        for (uint32_t i=0; i < DISTRHO_PLUGIN_NUM_OUTPUTS; ++i)
+        {
+            if (outputs[i] != inputs[i])
+                std::memcpy(outputs[i], inputs[i], sizeof(float)*frames);
+        }
+    }
+
+    // -------------------------------------------------------------------------------------------------------
+
+private:
+    float fParameters[NULL_PLUGIN_PARAMETER_COUNT];
+
+    DISTRHO_DECLARE_NON_COPY_CLASS(NullPlugin)
+};
+
+/* ------------------------------------------------------------------------------------------------------------
+ * Plugin entry point, called by DPF to create a new plugin instance. */
+
+Plugin* createPlugin()
+{
+    return new NullPlugin();
+}
+
+// -----------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
@@ -0,0 +1,322 @@
+/*
+ * DISTRHO Plugin Framework (DPF)
+ * Copyright (C) 2012-2016 Filipe Coelho <falktx@falktx.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with
+ * or without fee is hereby granted, provided that the above copyright notice and this
+ * permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+ * TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+ * NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+// Stand-in for libjack, linked into the JACK build of the null plugin instead of the real library.
+// Once the client is activated, the process callback is called in a loop for every buffer size and
+// MIDI density given in the environment, and the time per block is printed in the same format
+// as plugin_test_host -b. The plugin is asked to quit with SIGINT when done.
+//
+// DPF_BENCHMARK_FRAMES      buffer sizes, space separated (default "512")
+// DPF_BENCHMARK_MIDI        MIDI events per block, space separated (default "0")
+// DPF_BENCHMARK_ITERATIONS  blocks per measurement (default 1000)
+
+#include <jack/jack.h>
+#include <jack/midiport.h>
+#include <jack/transport.h>
+
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+// -----------------------------------------------------------------------
+
+static const uint32_t kMaxBufferSize   = 8192;
+static const uint32_t kMaxPorts        = 64;
+static const uint32_t kMaxMidiEvents   = 512;
+static const uint32_t kMaxMeasurements = 32;
+static const uint32_t kWarmupBlocks    = 64;
+
+struct _jack_client {
+    JackProcessCallback    processCallback;
+    void*                  processArg;
+    JackBufferSizeCallback bufferSizeCallback;
+    void*                  bufferSizeArg;
+    jack_nframes_t         bufferSize;
+    jack_nframes_t         frame;
+    pthread_t              thread;
+    bool                   threadRunning;
+};
+
+struct _jack_port {
+    bool   isMidi;
+    bool   isInput;
+    float* buffer;
+};
+
+static _jack_client gClient;
+static _jack_port   gPorts[kMaxPorts];
+static uint32_t     gPortCount = 0;
+
+static jack_midi_data_t gMidiData[kMaxMidiEvents][3];
+static jack_nframes_t   gMidiFrames[kMaxMidiEvents];
+static uint32_t         gMidiEventCount = 0;
+
+static uint32_t parseList(const char* const name, uint32_t* const values, const uint32_t fallback)
+{
+    const char* str = std::getenv(name);
+    uint32_t count = 0;
+
+    for (char* end; str != nullptr && *str != '\0' && count < kMaxMeasurements; str = end)
+    {
+        const long value = std::strtol(str, &end, 10);
+
+        if (end == str)
+            break;
+
+        values[count++] = static_cast<uint32_t>(value);
+    }
+
+    if (count == 0)
+        values[count++] = fallback;
+
+    return count;
+}
+
+static uint64_t getTimeNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+static void setMidiDensity(const uint32_t count, const jack_nframes_t frames)
+{
+    // evenly spread, alternating note on and off, same as plugin_test_host
+    gMidiEventCount = count < kMaxMidiEvents ? count : kMaxMidiEvents;
+
+    for (uint32_t i=0; i < gMidiEventCount; ++i)
+    {
+        gMidiFrames[i]  = i * frames / gMidiEventCount;
+        gMidiData[i][0] = (i & 1) ? 0x80 : 0x90;
+        gMidiData[i][1] = static_cast<jack_midi_data_t>(48 + (i/2) % 24);
+        gMidiData[i][2] = 100;
+    }
+}
+
+static void* benchmarkThread(void*)
+{
+    uint32_t frameList[kMaxMeasurements], midiList[kMaxMeasurements], iterations;
+    const uint32_t frameCount = parseList("DPF_BENCHMARK_FRAMES", frameList, 512);
+    const uint32_t midiCount  = parseList("DPF_BENCHMARK_MIDI", midiList, 0);
+    parseList("DPF_BENCHMARK_ITERATIONS", &iterations, 1000);
+
+    for (uint32_t f=0; f < frameCount; ++f)
+    {
+        const jack_nframes_t frames = frameList[f];
+
+        if (frames == 0 || frames > kMaxBufferSize)
+            continue;
+
+        if (frames != gClient.bufferSize)
+        {
+            gClient.bufferSize = frames;
+
+            if (gClient.bufferSizeCallback != nullptr)
+                gClient.bufferSizeCallback(frames, gClient.bufferSizeArg);
+        }
+
+        for (uint32_t m=0; m < midiCount; ++m)
+        {
+            setMidiDensity(midiList[m], frames);
+
+            uint64_t total = 0, min = 0;
+
+            for (uint32_t i=0; i < kWarmupBlocks + iterations; ++i)
+            {
+                const uint64_t start = getTimeNs();
+                gClient.processCallback(frames, gClient.processArg);
+                const uint64_t ns = getTimeNs() - start;
+
+                gClient.frame += frames;
+
+                if (i < kWarmupBlocks)
+                    continue;
+
+                if (i == kWarmupBlocks || ns < min)
+                    min = ns;
+                total += ns;
+            }
+
+            std::printf("%-6s %5u frames %4u params/block %6.1f midi/block %12.1f ns/block (min %.1f) %8.1f ns/param ok\n",
+                        "JACK", frames, 0U, static_cast<double>(gMidiEventCount),
+                        static_cast<double>(total) / static_cast<double>(iterations), static_cast<double>(min), 0.0);
+            std::fflush(stdout);
+        }
+    }
+
+    std::raise(SIGINT);
+    return nullptr;
+}
+
+// -----------------------------------------------------------------------
+// client
+
+jack_client_t* jack_client_open(const char*, jack_options_t, jack_status_t* status, ...)
+{
+    std::memset(&gClient, 0, sizeof(gClient));
+    gClient.bufferSize = 512;
+
+    // start with the first buffer size to measure, saves a reallocation
+    uint32_t frames;
+    parseList("DPF_BENCHMARK_FRAMES", &frames, 512);
+
+    if (frames != 0 && frames <= kMaxBufferSize)
+        gClient.bufferSize = frames;
+
+    if (status != nullptr)
+        *status = jack_status_t(0x0);
+
+    return &gClient;
+}
+
+int jack_client_close(jack_client_t*)
+{
+    return 0;
+}
+
+char* jack_get_client_name(jack_client_t*)
+{
+    return (char*)"Null";
+}
+
+int jack_activate(jack_client_t* client)
+{
+    if (client->processCallback == nullptr)
+        return 1;
+
+    client->threadRunning = pthread_create(&client->thread, nullptr, benchmarkThread, nullptr) == 0;
+    return client->threadRunning ? 0 : 1;
+}
+
+int jack_deactivate(jack_client_t* client)
+{
+    if (client->threadRunning && ! pthread_equal(client->thread, pthread_self()))
+    {
+        pthread_join(client->thread, nullptr);
+        client->threadRunning = false;
+    }
+
+    return 0;
+}
+
+jack_nframes_t jack_get_buffer_size(jack_client_t* client)
+{
+    return client->bufferSize;
+}
+
+jack_nframes_t jack_get_sample_rate(jack_client_t*)
+{
+    return 48000;
+}
+
+int jack_set_process_callback(jack_client_t* client, JackProcessCallback callback, void* arg)
+{
+    client->processCallback = callback;
+    client->processArg      = arg;
+    return 0;
+}
+
+int jack_set_buffer_size_callback(jack_client_t* client, JackBufferSizeCallback callback, void* arg)
+{
+    client->bufferSizeCallback = callback;
+    client->bufferSizeArg      = arg;
+    return 0;
+}
+
+int jack_set_sample_rate_callback(jack_client_t*, JackSampleRateCallback, void*)
+{
+    return 0;
+}
+
+void jack_on_shutdown(jack_client_t*, JackShutdownCallback, void*)
+{
+}
+
+// -----------------------------------------------------------------------
+// ports
+
+jack_port_t* jack_port_register(jack_client_t*, const char*, const char* portType, unsigned long flags, unsigned long)
+{
+    if (gPortCount == kMaxPorts)
+        return nullptr;
+
+    jack_port_t* const port = &gPorts[gPortCount++];
+    port->isMidi  = std::strcmp(portType, JACK_DEFAULT_MIDI_TYPE) == 0;
+    port->isInput = (flags & JackPortIsInput) != 0;
+    port->buffer  = new float[kMaxBufferSize]();
+    return port;
+}
+
+int jack_port_unregister(jack_client_t*, jack_port_t* port)
+{
+    delete[] port->buffer;
+    port->buffer = nullptr;
+    return 0;
+}
+
+void* jack_port_get_buffer(jack_port_t* port, jack_nframes_t)
+{
+    return port->isMidi ? (void*)port : (void*)port->buffer;
+}
+
+// -----------------------------------------------------------------------
+// MIDI, port buffers of MIDI ports are the ports themselves
+
+uint32_t jack_midi_get_event_count(void* portBuffer)
+{
+    return ((jack_port_t*)portBuffer)->isInput ? gMidiEventCount : 0;
+}
+
+int jack_midi_event_get(jack_midi_event_t* event, void*, uint32_t index)
+{
+    if (index >= gMidiEventCount)
+        return ENODATA;
+
+    event->time   = gMidiFrames[index];
+    event->size   = 3;
+    event->buffer = gMidiData[index];
+    return 0;
+}
+
+void jack_midi_clear_buffer(void*)
+{
+}
+
+int jack_midi_event_write(void*, jack_nframes_t, const jack_midi_data_t*, size_t)
+{
+    return 0;
+}
+
+// -----------------------------------------------------------------------
+// transport
+
+jack_transport_state_t jack_transport_query(const jack_client_t* client, jack_position_t* pos)
+{
+    if (pos != nullptr)
+    {
+        std::memset(pos, 0, sizeof(jack_position_t));
+        pos->frame_rate = 48000;
+        pos->frame      = client->frame;
+    }
+
+    return JackTransportRolling;
+}
@@ -0,0 +1,270 @@
+/*
+ * DISTRHO Plugin Framework (DPF)
+ * Copyright (C) 2012-2016 Filipe Coelho <falktx@falktx.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with
+ * or without fee is hereby granted, provided that the above copyright notice and this
+ * permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+ * TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+ * NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+// Session save and restore benchmark for the LV2 state interface.
+// Instantiates many plugins with a stand-in URID map, like a host with a large session open,
+// then times saving and restoring the state of all of them and counts the URID map calls made.
+
+#include "../../distrho/src/lv2/atom.h"
+#include "../../distrho/src/lv2/buf-size.h"
+#include "../../distrho/src/lv2/lv2.h"
+#include "../../distrho/src/lv2/options.h"
+#include "../../distrho/src/lv2/state.h"
+#include "../../distrho/src/lv2/urid.h"
+#include "../../distrho/src/lv2/worker.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <dlfcn.h>
+#include <stdint.h>
+#include <time.h>
+
+// -----------------------------------------------------------------------
+
+static uint64_t getTimeNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+// URID map as a typical host implements it, every call is a string lookup
+struct StandInUridMap {
+    std::map<std::string, LV2_URID> urids;
+    uint32_t calls;
+
+    StandInUridMap()
+        : urids(),
+          calls(0) {}
+
+    static LV2_URID _map(LV2_URID_Map_Handle handle, const char* uri)
+    {
+        StandInUridMap* const self((StandInUridMap*)handle);
+        ++self->calls;
+
+        const std::map<std::string, LV2_URID>::iterator it(self->urids.find(uri));
+
+        if (it != self->urids.end())
+            return it->second;
+
+        const LV2_URID urid(static_cast<LV2_URID>(self->urids.size() + 1));
+        self->urids[uri] = urid;
+        return urid;
+    }
+};
+
+struct StoredProperty {
+    uint32_t key;
+    uint32_t type;
+    uint32_t flags;
+    std::string value;
+};
+
+typedef std::vector<StoredProperty> StoredState;
+
+static LV2_State_Status _store(LV2_State_Handle handle, uint32_t key, const void* value, size_t size, uint32_t type, uint32_t flags)
+{
+    StoredProperty prop;
+    prop.key   = key;
+    prop.type  = type;
+    prop.flags = flags;
+    prop.value.assign((const char*)value, size);
+
+    ((StoredState*)handle)->push_back(prop);
+    return LV2_STATE_SUCCESS;
+}
+
+static const void* _retrieve(LV2_State_Handle handle, uint32_t key, size_t* size, uint32_t* type, uint32_t* flags)
+{
+    const StoredState& state(*(const StoredState*)handle);
+
+    for (std::size_t i=0; i < state.size(); ++i)
+    {
+        if (state[i].key != key)
+            continue;
+
+        *size  = state[i].value.size();
+        *type  = state[i].type;
+        *flags = state[i].flags;
+        return state[i].value.data();
+    }
+
+    return nullptr;
+}
+
+// nothing is scheduled while saving or restoring, only needed to instantiate
+static LV2_Worker_Status _scheduleWork(LV2_Worker_Schedule_Handle, uint32_t, const void*)
+{
+    return LV2_WORKER_SUCCESS;
+}
+
+// -----------------------------------------------------------------------
+
+int main(int argc, char* argv[])
+{
+    uint32_t instanceCount = 500;
+    uint32_t sessionCount  = 20;
+    const char* filename   = nullptr;
+
+    for (int i=1; i < argc; ++i)
+    {
+        /**/ if (std::strcmp(argv[i], "-i") == 0 && i+1 < argc)
+            instanceCount = static_cast<uint32_t>(std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "-n") == 0 && i+1 < argc)
+            sessionCount = static_cast<uint32_t>(std::atoi(argv[++i]));
+        else
+            filename = argv[i];
+    }
+
+    if (filename == nullptr || instanceCount == 0 || sessionCount == 0)
+    {
+        std::fprintf(stderr, "usage: %s [-i instances] [-n sessions] /path/to/plugin.so\n", argv[0]);
+        return 1;
+    }
+
+    void* const lib = dlopen(filename, RTLD_NOW|RTLD_LOCAL);
+
+    if (lib == nullptr)
+    {
+        std::fprintf(stderr, "Failed to open plugin DLL, error was:\n%s\n", dlerror());
+        return 1;
+    }
+
+    const LV2_Descriptor_Function descFn = (LV2_Descriptor_Function)dlsym(lib, "lv2_descriptor");
+    const LV2_Descriptor* const descriptor = descFn != nullptr ? descFn(0) : nullptr;
+    const LV2_State_Interface* const state = descriptor != nullptr && descriptor->extension_data != nullptr
+                                           ? (const LV2_State_Interface*)descriptor->extension_data(LV2_STATE__interface)
+                                           : nullptr;
+
+    if (state == nullptr)
+    {
+        std::fprintf(stderr, "Plugin has no LV2 state interface\n");
+        dlclose(lib);
+        return 1;
+    }
+
+    // host features
+    StandInUridMap uridMapData;
+    LV2_URID_Map uridMap = { &uridMapData, StandInUridMap::_map };
+
+    int bufferSize = 512;
+    const LV2_URID atomInt = uridMap.map(uridMap.handle, LV2_ATOM__Int);
+
+    const LV2_Options_Option options[] = {
+        { LV2_OPTIONS_INSTANCE, 0, uridMap.map(uridMap.handle, LV2_BUF_SIZE__nominalBlockLength), sizeof(int), atomInt, &bufferSize },
+        { LV2_OPTIONS_INSTANCE, 0, uridMap.map(uridMap.handle, LV2_BUF_SIZE__maxBlockLength),     sizeof(int), atomInt, &bufferSize },
+        { LV2_OPTIONS_INSTANCE, 0, 0, 0, 0, nullptr }
+    };
+
+    LV2_Worker_Schedule workSchedule = { nullptr, _scheduleWork };
+
+    const LV2_Feature featureUridMap = { LV2_URID__map, &uridMap };
+    const LV2_Feature featureOptions = { LV2_OPTIONS__options, (void*)options };
+    const LV2_Feature featureWorker  = { LV2_WORKER__schedule, &workSchedule };
+    const LV2_Feature* const features[] = { &featureUridMap, &featureOptions, &featureWorker, nullptr };
+
+    // open the session
+    std::vector<LV2_Handle> handles;
+    handles.reserve(instanceCount);
+
+    uridMapData.calls = 0;
+    uint64_t start = getTimeNs();
+
+    for (uint32_t i=0; i < instanceCount; ++i)
+    {
+        if (LV2_Handle const handle = descriptor->instantiate(descriptor, 48000.0, "", features))
+            handles.push_back(handle);
+    }
+
+    const uint64_t instantiateNs = getTimeNs() - start;
+    const uint32_t instantiateCalls = uridMapData.calls;
+
+    if (handles.size() != instanceCount)
+    {
+        std::fprintf(stderr, "Only %u of %u instances were created\n", static_cast<uint32_t>(handles.size()), instanceCount);
+
+        for (std::size_t i=0; i < handles.size(); ++i)
+            descriptor->cleanup(handles[i]);
+
+        dlclose(lib);
+        return 1;
+    }
+
+    // save and restore the whole session a few times
+    std::vector<StoredState> session(handles.size());
+    uint64_t saveTotal = 0, saveMin = 0, restoreTotal = 0, restoreMin = 0;
+    uint32_t saveCalls = 0, restoreCalls = 0, propertyCount = 0;
+
+    for (uint32_t s=0; s < sessionCount; ++s)
+    {
+        for (std::size_t i=0; i < session.size(); ++i)
+        {
+            session[i].clear();
+            session[i].reserve(64);
+        }
+
+        uridMapData.calls = 0;
+        start = getTimeNs();
+
+        for (std::size_t i=0; i < handles.size(); ++i)
+            state->save(handles[i], _store, &session[i], LV2_STATE_IS_POD|LV2_STATE_IS_PORTABLE, nullptr);
+
+        const uint64_t saveNs = getTimeNs() - start;
+        saveCalls = uridMapData.calls;
+
+        uridMapData.calls = 0;
+        start = getTimeNs();
+
+        for (std::size_t i=0; i < handles.size(); ++i)
+            state->restore(handles[i], _retrieve, &session[i], LV2_STATE_IS_POD|LV2_STATE_IS_PORTABLE, nullptr);
+
+        const uint64_t restoreNs = getTimeNs() - start;
+        restoreCalls = uridMapData.calls;
+
+        saveTotal    += saveNs;
+        restoreTotal += restoreNs;
+
+        if (s == 0 || saveNs < saveMin)
+            saveMin = saveNs;
+        if (s == 0 || restoreNs < restoreMin)
+            restoreMin = restoreNs;
+    }
+
+    for (std::size_t i=0; i < session.size(); ++i)
+        propertyCount += static_cast<uint32_t>(session[i].size());
+
+    for (std::size_t i=0; i < handles.size(); ++i)
+        descriptor->cleanup(handles[i]);
+
+    dlclose(lib);
+
+    const double sessions = static_cast<double>(sessionCount);
+
+    std::printf("%u instances, %u state properties per session\n", static_cast<uint32_t>(handles.size()), propertyCount);
+    std::printf("instantiate %12.1f us/session                    %6u urid map calls\n",
+                static_cast<double>(instantiateNs) / 1000.0, instantiateCalls);
+    std::printf("save        %12.1f us/session (min %10.1f)   %6u urid map calls\n",
+                static_cast<double>(saveTotal) / sessions / 1000.0, static_cast<double>(saveMin) / 1000.0, saveCalls);
+    std::printf("restore     %12.1f us/session (min %10.1f)   %6u urid map calls\n",
+                static_cast<double>(restoreTotal) / sessions / 1000.0, static_cast<double>(restoreMin) / 1000.0, restoreCalls);
+
+    return 0;
+}
@@ -0,0 +1,157 @@
+/*
+ * DISTRHO Plugin Framework (DPF)
+ * Copyright (C) 2012-2016 Filipe Coelho <falktx@falktx.com>
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any purpose with
+ * or without fee is hereby granted, provided that the above copyright notice and this
+ * permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES WITH REGARD
+ * TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS. IN
+ * NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL
+ * DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+// Voices-per-core benchmark for VoiceEngine.
+// Renders a simple oscillator per voice with an increasing number of held notes and reports
+// how many voices a single core could run in real-time at the given buffer size.
+
+#include "extra/VoiceEngine.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+
+#include <time.h>
+
+USE_NAMESPACE_DISTRHO
+
+// -----------------------------------------------------------------------
+
+static const uint32_t kMaxBenchVoices = 256;
+static const uint32_t kBufferSize     = 256;
+static const double   kSampleRate     = 48000.0;
+
+static uint64_t getTimeNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+class BenchSynth : public VoiceEngine<kMaxBenchVoices>
+{
+public:
+    BenchSynth()
+        : VoiceEngine<kMaxBenchVoices>(kVoiceStealOldest)
+    {
+        for (uint32_t v=0; v<kVoiceCount; ++v)
+        {
+            fPhase[v]     = 0.0f;
+            fIncrement[v] = 0.0f;
+        }
+    }
+
+protected:
+    void renderVoices(float** outputs, uint32_t frames) override
+    {
+        const uint32_t count = getVoiceRenderCount();
+
+        for (uint32_t i=0; i<frames; ++i)
+        {
+            float sum = 0.0f;
+
+            // whole lanes, no branches on the voice state
+            for (uint32_t v=0; v<count; ++v)
+            {
+                float phase = fPhase[v] + fIncrement[v];
+                phase -= phase >= 1.0f ? 1.0f : 0.0f;
+                fPhase[v] = phase;
+
+                // parabolic sine approximation
+                const float x = 2.0f * phase - 1.0f;
+                sum += fVoiceGain[v] * fVoiceVelocity[v] * 4.0f * x * (1.0f - std::fabs(x));
+            }
+
+            outputs[0][i] += sum;
+            outputs[1][i] += sum;
+        }
+    }
+
+    void voiceStarted(uint32_t voice) override
+    {
+        fPhase[voice]     = 0.0f;
+        fIncrement[voice] = static_cast<float>(fVoiceFrequency[voice] / kSampleRate);
+    }
+
+private:
+    float fPhase[kVoiceCount];
+    float fIncrement[kVoiceCount];
+};
+
+// -----------------------------------------------------------------------
+
+int main(int argc, char* argv[])
+{
+    const uint32_t iterations = argc > 1 ? static_cast<uint32_t>(std::atoi(argv[1])) : 2000;
+
+    if (iterations == 0)
+    {
+        std::fprintf(stderr, "usage: %s [iterations]\n", argv[0]);
+        return 1;
+    }
+
+    static const uint32_t voiceCounts[] = { 1, 4, 16, 32, 64, 128, 256 };
+
+    float left[kBufferSize], right[kBufferSize];
+    float* outputs[2] = { left, right };
+
+    const double blockNs = static_cast<double>(kBufferSize) / kSampleRate * 1e9;
+
+    for (uint32_t c=0; c < sizeof(voiceCounts)/sizeof(voiceCounts[0]); ++c)
+    {
+        const uint32_t voices = voiceCounts[c];
+
+        BenchSynth synth;
+        MidiEvent events[kMaxBenchVoices];
+
+        // all notes start at the first block, spread over channels so none is retriggered
+        for (uint32_t v=0; v<voices; ++v)
+        {
+            events[v].frame   = 0;
+            events[v].size    = 3;
+            events[v].data[0] = static_cast<uint8_t>(0x90 | (v % 16));
+            events[v].data[1] = static_cast<uint8_t>(36 + (v / 16) * 3 + v % 3);
+            events[v].data[2] = 100;
+            events[v].dataExt = nullptr;
+        }
+
+        synth.processVoices(outputs, kBufferSize, events, voices);
+
+        uint64_t total = 0, min = 0;
+        float check = 0.0f;
+
+        for (uint32_t i=0; i<iterations; ++i)
+        {
+            const uint64_t start = getTimeNs();
+            synth.processVoices(outputs, kBufferSize, nullptr, 0);
+            const uint64_t ns = getTimeNs() - start;
+
+            if (i == 0 || ns < min)
+                min = ns;
+            total += ns;
+            check += left[i % kBufferSize];
+        }
+
+        const double avgNs = static_cast<double>(total) / static_cast<double>(iterations);
+
+        std::printf("%4u voices (%3u active) %10.1f ns/block (min %8.1f) %7.2f ns/voice-frame %8.0f voices/core%s\n",
+                    voices, synth.getActiveVoiceCount(), avgNs, static_cast<double>(min),
+                    avgNs / static_cast<double>(voices * kBufferSize),
+                    static_cast<double>(voices) * blockNs / avgNs,
+                    std::isfinite(check) ? "" : " FAILED");
+    }
+
+    return 0;
+}